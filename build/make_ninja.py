@@ -62,28 +62,58 @@ class Writer(ninja_syntax.Writer):
 
 
 SOURCE_FILES = [
+  'source/agents.cpp',
+  'source/alloctrack.cpp',
+  'source/arena.cpp',
+  'source/atlas.cpp',
   'source/background.cpp',
+  'source/botinput.cpp',
   'source/color.cpp',
+  'source/fixed.cpp',
+  'source/framecapture.cpp',
+  'source/framepacer.cpp',
+  'source/gl3renderer.cpp',
+  'source/image.cpp',
+  'source/input.cpp',
+  'source/layercache.cpp',
+  'source/legacyrenderer.cpp',
+  'source/level.cpp',
+  'source/maploader.cpp',
+  'source/memory.cpp',
   'source/misc.cpp',
+  'source/navgraph.cpp',
   'source/object.cpp',
   'source/particle.cpp',
+  'source/physics.cpp',
   'source/player.cpp',
   'source/point.cpp',
   'source/region.cpp',
+  'source/renderer.cpp',
+  'source/rollback.cpp',
   'source/segment.cpp',
-  'source/simfun.cpp',
+  'source/segmentbatch.cpp',
   'source/simulation.cpp',
+  'source/snapshot.cpp',
+  'source/softrenderer.cpp',
+  'source/spritebatch.cpp',
   'source/tilemap.cpp',
   'source/tiles.cpp',
   'source/vector.cpp',
   'source/walls.cpp',
   'source/wallset.cpp',
+  'source/walltree.cpp',
+  'source/watcher.cpp',
 ]
+# Each program is linked from SOURCE_FILES plus its own main.
+PROGRAMS = {
+  'simfun': ['source/simfun.cpp'],
+  'bench': ['source/bench.cpp'],
+}
 DATA_FILES = []
 MAKE_NINJA = './build/make_ninja.py'
 
 
-def Code(w):
+def Code(w, options):
   w.newline()
   w.rule('cc',
       command='$cc $cflags -MMD -MF $out.d -c $in -o $out',
@@ -97,6 +127,10 @@ def Code(w):
 
   flags = '-g'
   defines = Prefix('-D', '_GNU_SOURCE=1 _REENTRANT')
+  if options.track_allocs:
+    defines = Join(defines, Prefix('-D', 'SIMFUN_TRACK_ALLOCS'))
+  if options.fixed_point:
+    defines = Join(defines, Prefix('-D', 'SIMFUN_FIXED_POINT'))
   includes = Prefix('-I', 'include')
 
   for bits, flavor in (('32', 'i686-nacl'), ('64', 'x86_64-nacl')):
@@ -112,15 +146,17 @@ def Code(w):
         '-L$usr_lib{bits} {libs}'.format(**vars()))
     w.variable('cc' + bits, '$toolchain_dir/bin/{flavor}-g++'.format(**vars()))
 
-    sources = SOURCE_FILES
-    objs = [SourceToObj(x, bits) for x in sources]
-    for source, obj in zip(sources, objs):
-      w.build(obj, 'cc', source,
+    sources = SOURCE_FILES + sum(PROGRAMS.values(), [])
+    for source in sources:
+      w.build(SourceToObj(source, bits), 'cc', source,
           variables={'cflags': '$cflags' + bits, 'cc': '$cc' + bits})
 
-    w.build('out/simfun.{bits}.nexe'.format(**vars()), 'link', objs,
-        variables={'ldflags': '$ldflags' + bits,
-                   'cc': '$cc' + bits})
+    objs = [SourceToObj(x, bits) for x in SOURCE_FILES]
+    for name, mains in sorted(PROGRAMS.items()):
+      w.build('out/{0}.{1}.nexe'.format(name, bits), 'link',
+          objs + [SourceToObj(x, bits) for x in mains],
+          variables={'ldflags': '$ldflags' + bits,
+                     'cc': '$cc' + bits})
 
 
 def Data(w):
@@ -129,18 +165,23 @@ def Data(w):
 
 def main():
   parser = optparse.OptionParser()
+  parser.add_option('--track-allocs', action='store_true', default=False,
+      help='count every heap allocation (see bench -noalloc)')
+  parser.add_option('--fixed-point', action='store_true', default=False,
+      help='simulate in fixed point, the same on every machine')
   options, args = parser.parse_args()
 
   out_filename = os.path.join(os.path.dirname(__file__), '../build.ninja')
   f = cStringIO.StringIO()
   w = Writer(f)
 
-  w.rule('configure', command = MAKE_NINJA, generator=1)
+  w.rule('configure', command = ' '.join([MAKE_NINJA] + sys.argv[1:]),
+      generator=1)
   w.build('build.ninja', 'configure', implicit=[MAKE_NINJA])
   w.variable('nacl_sdk_usr', '/dev/naclsdk/nacl_sdk/pepper_21')
   w.variable('toolchain_dir', '$nacl_sdk_usr/toolchain/win_x86_newlib')
 
-  Code(w)
+  Code(w, options)
   Data(w)
 
   # Don't write build.ninja until everything succeeds
@@ -0,0 +1,57 @@
+#ifndef __AGENTS_H__
+#define __AGENTS_H__
+
+#include <vector>
+#include "object.h"
+#include "player.h"
+#include "wallset.h"
+
+class Background;
+class Snapshot;
+class SpriteBatch;
+
+/* lots of players in the same world (bots, crowds). they live in one
+	array, and their wall queries are shared: players that touch the same
+	tiles get their walls gathered once per tick */
+class Agents
+{
+/* types */
+private:
+	struct Query
+	{
+		Object::TileBounds bounds;
+		int agent;
+
+		bool operator <(const Query &q) const { return bounds < q.bounds; }
+	};
+
+/* fields */
+private:
+	std::vector<Player> agents;
+	std::vector<Query> queries;
+
+/* constructors */
+public:
+	Agents() {}
+
+/* methods */
+public:
+	int add(const Player &proto, const Point &p);
+	void clear() { agents.clear(); }
+	void clearIgnore();
+	void update(Background &bg);
+	void draw(SpriteBatch &batch);
+	void save(Snapshot &s) const;
+	void restore(Snapshot &s);
+
+/* setters */
+public:
+	void setInput(int agent, int buttons) { agents[agent].setInput(buttons); }
+
+/* getters */
+public:
+	int size() const { return agents.size(); }
+	Player & get(int agent) { return agents[agent]; }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef __ALLOC_TRACK_H__
+#define __ALLOC_TRACK_H__
+
+/* counts heap allocations, by what the program was doing when they
+	happened. the counting is only compiled in with SIMFUN_TRACK_ALLOCS
+	(it replaces the global operator new and delete); without it the tags
+	still work, but nothing is counted and isEnabled() returns false */
+class AllocTracker
+{
+/* types */
+public:
+	enum Tag
+	{
+		OTHER,
+		PLAYER,
+		AGENTS,
+		PARTICLES,
+		RENDER,
+		LOADER,
+		NUM_TAGS
+	};
+
+	/* frees are counted for the tag that's set when they happen, not
+		the one the memory was allocated with */
+	struct Stats
+	{
+		long allocs, frees;
+		long bytesAllocated, bytesFreed;
+	};
+
+	/* sets the tag of this thread until it goes out of scope */
+	class Scope
+	{
+	/* fields */
+	private:
+		Tag old;
+
+	/* constructors */
+	public:
+		Scope(Tag tag): old(AllocTracker::getTag()) { AllocTracker::setTag(tag); }
+		~Scope() { AllocTracker::setTag(old); }
+	};
+
+/* methods */
+public:
+	static bool isEnabled();
+	static void setTag(Tag tag);
+	static Tag getTag();
+	static const char *getTagName(Tag tag);
+	/* counters since the program started, for every tag */
+	static void getStats(Stats stats[NUM_TAGS]);
+	/* bytes allocated and not freed yet, over all tags */
+	static long getLiveBytes();
+};
+
+#endif
\ No newline at end of file
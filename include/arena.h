@@ -0,0 +1,84 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include "memory.h"
+
+/* hands out memory from a few big blocks, and frees it all at once. small
+	allocations that are given back go on a free list for their size and
+	are reused (building walls creates and throws away lots of list nodes),
+	but memory only goes back to the system with the arena (or release()).
+	used for things that all have the same lifetime, like everything built
+	for a map, or everything that's only needed during one tick.
+
+	an arena belongs to one thread. to build with more, each extra thread
+	attach()es to a fork(), and until it calls detach() everything it
+	allocates from (or gives back to) the arena goes to the fork instead;
+	join() hands the fork's memory over once that thread is done */
+class Arena : public MemoryResource
+{
+/* types */
+private:
+	struct Block
+	{
+		Block *next;
+		size_t size, used;
+	};
+
+/* fields */
+private:
+	static const size_t DEFAULT_BLOCK_SIZE;
+	static const size_t HEADER_SIZE;
+	enum
+	{
+		/* free lists are kept for sizes up to MAX_FREE_SIZE, rounded up to
+			FREE_GRANULE bytes */
+		FREE_GRANULE = 8,
+		MAX_FREE_SIZE = 256,
+		NUM_FREE_LISTS = MAX_FREE_SIZE / FREE_GRANULE + 1
+	};
+
+	Block *blocks;
+	void *freeLists[NUM_FREE_LISTS];
+	size_t blockSize;
+	size_t totalUsed, totalSize;
+	int numBlocks;
+	/* the arena this is a fork of, NULL if it isn't one */
+	Arena *parent;
+
+/* constructors */
+public:
+	Arena(size_t _blockSize = DEFAULT_BLOCK_SIZE);
+	~Arena() { release(); }
+
+private:
+	/* not copyable */
+	Arena(const Arena &);
+	Arena &operator =(const Arena &);
+
+/* methods */
+private:
+	void newBlock(size_t minSize);
+
+public:
+	void *allocate(size_t n, size_t align);
+	void deallocate(void *p, size_t n);
+	void release();
+	/* forgets everything allocated, but keeps the memory. if more than
+		one block was needed, they're replaced by one big enough for all,
+		so an arena that's reset every tick stops allocating quickly */
+	void reset();
+
+	Arena *fork();
+	void join(Arena *f);
+	/* for this thread, until detach() */
+	void attach();
+	static void detach();
+
+/* getters */
+public:
+	size_t getUsed() const { return totalUsed; }
+	size_t getSize() const { return totalSize; }
+	int getNumBlocks() const { return numBlocks; }
+};
+
+#endif
\ No newline at end of file
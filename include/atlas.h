@@ -0,0 +1,100 @@
+#ifndef __ATLAS_H__
+#define __ATLAS_H__
+
+#include <string>
+#include <vector>
+#include "SDL_opengl.h"
+#include "SDL.h"
+#include "image.h"
+
+/* texture coordinates of one image packed into the atlas */
+struct Sprite
+{
+/* fields */
+	float u0, v0, u1, v1;
+	int w, h;
+
+/* constructors */
+	Sprite() : u0(0), v0(0), u1(0), v1(0), w(0), h(0) {}
+};
+
+class Atlas
+{
+/* types */
+private:
+	/* an image file to pack; grid images are split into cellW x cellH
+		sprites, so every cell is packed on its own */
+	struct Source
+	{
+		std::string file;
+		Image image;
+		int cellW, cellH;
+		int padding;
+		bool grid;
+		int firstSprite, numSprites;
+
+		Source(const char *_file, int _cellW, int _cellH, int _padding, int _first):
+			file(_file), cellW(_cellW), cellH(_cellH),
+			padding(_padding), grid(false), firstSprite(_first), numSprites(0) {}
+	};
+
+	/* a single rectangle to pack */
+	struct Cell
+	{
+		const Image *image;
+		int x, y, w, h;		/* source rectangle in image */
+		int padding;
+		int sprite;
+		int atlasX, atlasY;	/* upper left of the padded rectangle */
+	};
+
+	struct TallerThan
+	{
+		bool operator ()(const Cell &a, const Cell &b) const { return a.h > b.h; }
+	};
+
+/* consts */
+private:
+	/* single images are surrounded by a one texel border, copied from the
+		image edges, so GL_LINEAR filtering doesn't bleed between sprites when
+		they are rotated or scaled. grid cells (tiles) are always drawn 1:1 on
+		pixel boundaries, so they don't need it */
+	static const int PADDING;
+
+/* fields */
+private:
+	std::vector<Source> sources;
+	std::vector<Sprite> sprites;
+	int white;
+
+	Image image;
+	GLuint texture;
+
+/* constructors */
+public:
+	Atlas();
+	~Atlas();
+
+/* methods */
+private:
+	bool pack(std::vector<Cell> &cells, int width, int &height);
+	void copyCell(const Cell &c);
+	void extrudeCell(const Cell &c);
+	void upload();
+
+public:
+	int add(const char *file);
+	int addGrid(const char *file, int cellW, int cellH);
+	/* packs the images; the texture is only made if uploadTexture is set */
+	bool build(bool uploadTexture = true);
+	bool reload();
+
+/* getters */
+public:
+	const Sprite & getSprite(int index) const { return sprites[index]; }
+	const Sprite & getWhite() const { return sprites[white]; }
+	const Image & getImage() const { return image; }
+	GLuint getTexture() const { return texture; }
+};
+
+#endif
@@ -1,68 +1,77 @@
 #ifndef __BACKGROUND_H__
 #define __BACKGROUND_H__
 
-#include <stack>
 #include "SDL_opengl.h"
 #include "SDL.h"
 #include "tiles.h"
 #include "tilemap.h"
-#include "region.h"
+#include "level.h"
+#include "walltree.h"
 
-class Walls;
+class Atlas;
+class SpriteBatch;
 
 class Background
 {
 /* types */
-private:
-	/* used for seed fill */
-	struct Strip
+public:
+	struct Ray
+	{
+		Point origin;
+		Vector dir;
+		float maxDist;
+
+		Ray() : maxDist(0) {}
+		Ray(const Point &_origin, const Vector &_dir, float _maxDist):
+			origin(_origin), dir(_dir), maxDist(_maxDist) {}
+	};
+
+	struct RayHit
 	{
-		int xl, xr, y, dy;
-		Strip(int _xl, int _xr, int _y, int _dy): 
-			xl(_xl), xr(_xr), y(_y), dy(_dy) {}
+		/* NULL if nothing was hit */
+		const Wall *wall;
+		Point point;
+		/* the wall's normal, flipped to the side the ray came from */
+		Vector normal;
+		float dist;
 	};
 
 /* fields */
 private:
-	Tile::TileType *map;
-	SDL_Surface *image;
+	Level *level;
 	int tileWidth, tileHeight;
-	GLuint tiles;
-
-	bool *mappedTile;
-	TileMap *tilemap;
-	Walls *walls;
-	Region::List regions;
+	int tiles;
 
 /* constructors */
 public:
 	Background(): 
-		tileWidth(80), tileHeight(60),
-		tilemap(NULL), map(NULL), image(NULL), walls(NULL) {}
+		level(NULL), tileWidth(80), tileHeight(60), tiles(0) {}
 	~Background();
 
 /* methods */
-private:
-	void readMapFromFile(const char *file);
-	void mapRegions();
-	void clearMappedTile();
-	bool checkIndex(int i, int j, Tile::TileType type);
-	void paintIndex(Region &region, int i, int j);
-	void regionFill(Region &region, int i, int j);
-
 public:
-	void loadTiles(const char *file);
-	void loadMap(const char *file);
+	void loadTiles(Atlas &atlas, const char *file);
+	void setLevel(Level *l);
 	void deleteMap();
-	void drawTiles();
-	void drawWalls();
+	void drawTiles(SpriteBatch &batch);
+	void drawWalls(SpriteBatch &batch);
+
+	/* first wall (of the types in the mask; see WallTree) within maxDist
+		of origin, going in dir. walks the tiles the ray passes through, in
+		order, so it stops as soon as it finds something */
+	bool raycast(const Point &origin, const Vector &dir, float maxDist,
+		RayHit &hit, int types = WallTree::ALL_TYPES) const;
+	/* the same for n rays; returns how many hit something */
+	int raycast(const Ray *rays, int n, RayHit *hits,
+		int types = WallTree::ALL_TYPES) const;
 
 /* getters */
 public:
-	const Tile::TileType & mapIndex(int i, int j) const { return map[j*tileWidth+i]; }
-	Tile::TileType & mapIndex(int i, int j) { return map[j*tileWidth+i]; }
-	const TileMap & getTileMap() const { return *tilemap; }
-	TileMap & getTileMap() { return *tilemap; }
+	const Tile::TileType & mapIndex(int i, int j) const { return level->mapIndex(i,j); }
+	Tile::TileType & mapIndex(int i, int j) { return level->mapIndex(i,j); }
+	const TileMap & getTileMap() const { return level->getTileMap(); }
+	TileMap & getTileMap() { return level->getTileMap(); }
+	const Level * getLevel() const { return level; }
 	int getTileWidth() const { return tileWidth; }
 	int getTileHeight() const { return tileHeight; }
 };
@@ -0,0 +1,67 @@
+#ifndef __BOT_INPUT_H__
+#define __BOT_INPUT_H__
+
+#include "input.h"
+#include "navgraph.h"
+
+class Background;
+class Level;
+class Player;
+
+/* presses buttons to get a player somewhere: finds a path on the level's
+	NavGraph, and steers toward each waypoint in turn, the way the link to
+	it needs (walking, jumping, climbing or swimming). waypoints that can
+	be walked to in a straight line, with no wall in between, are skipped.
+	without a goal of its own, it wanders between places picked at
+	random. it has its own random numbers, so it doesn't change what the
+	game does with frand */
+class BotInput : public InputSource
+{
+/* fields */
+private:
+	/* the path is found again this often, in case the player got knocked
+		off it */
+	static const int REPLAN_TICKS;
+	/* a waypoint not reached in this long is given up on, with its goal */
+	static const int STUCK_TICKS;
+
+	Player &player;
+	const Background &bg;
+	/* the level the path is on */
+	const Level *level;
+
+	Point goal;
+	bool hasGoal, wander;
+	NavGraph::Path path;
+	/* the waypoint being headed for */
+	unsigned int next;
+	int sinceReplan, sinceProgress;
+	int lastButtons;
+	Uint32 randomState;
+
+/* constructors */
+public:
+	BotInput(Player &_player, const Background &_bg);
+
+/* methods */
+private:
+	Uint32 random();
+	bool pickGoal();
+	bool plan();
+	bool reached(unsigned int k);
+	void skipAhead();
+	int steer();
+
+public:
+	int nextButtons();
+	/* heads for p, and stops there */
+	void setGoal(const Point &p);
+	/* wanders from place to place */
+	void clearGoal();
+
+/* getters */
+public:
+	const NavGraph::Path & getPath() const { return path; }
+};
+
+#endif
\ No newline at end of file
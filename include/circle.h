@@ -7,10 +7,10 @@ struct Circle
 {
 /* fields */
 	Point center;
-	float radius;
+	real radius;
 
 /* constructors */
-	Circle(const Point &c, float r) : center(c), radius(r) {}
+	Circle(const Point &c, real r) : center(c), radius(r) {}
 
 /* methods */
 };
@@ -0,0 +1,92 @@
+#ifndef __FIXED_H__
+#define __FIXED_H__
+
+#include "SDL.h"
+
+/* a number with 16 bits after the point, kept in a 64 bit integer. all the
+	arithmetic is integer arithmetic, so it gives the same answers with any
+	compiler on any cpu, which float doesn't (x87 vs SSE, contraction,
+	different libm). see real in global.h.
+
+	the 64 bits leave room for squared distances across a whole map: a
+	product or quotient is good as long as it's under 2^31 */
+class Fixed
+{
+/* fields */
+public:
+	static const int FRAC_BITS = 16;
+	static const Sint64 ONE = (Sint64)1 << FRAC_BITS;
+
+private:
+	Sint64 raw;
+
+/* constructors */
+public:
+	Fixed() : raw(0) {}
+	Fixed(int i) : raw((Sint64)i << FRAC_BITS) {}
+	Fixed(float f) : raw(fromDouble(f)) {}
+	Fixed(double d) : raw(fromDouble(d)) {}
+
+	static Fixed fromRaw(Sint64 r) { Fixed f; f.raw = r; return f; }
+	/* what dividing by zero gives */
+	static Fixed max() { return fromRaw((Sint64)1 << 62); }
+
+/* methods */
+private:
+	/* the scaling is exact, so only the rounding can lose anything */
+	static Sint64 fromDouble(double d) { d *= ONE; return (Sint64)(d < 0 ? d - 0.5 : d + 0.5); }
+
+public:
+	Fixed & operator +=(const Fixed &a) { raw += a.raw; return *this; }
+	Fixed & operator -=(const Fixed &a) { raw -= a.raw; return *this; }
+	Fixed & operator *=(const Fixed &a) { raw = (raw * a.raw) >> FRAC_BITS; return *this; }
+	/* dividing by zero saturates instead of trapping, like float's inf */
+	Fixed & operator /=(const Fixed &a)
+	{
+		if (a.raw) raw = (raw << FRAC_BITS) / a.raw;
+		else raw = raw < 0 ? -max().raw : max().raw;
+		return *this;
+	}
+	Fixed operator -() const { return fromRaw(-raw); }
+	Fixed operator +() const { return *this; }
+
+	/* for drawing, and anything else outside the simulation */
+	operator float() const { return (float)raw / ONE; }
+
+/* getters */
+public:
+	Sint64 getRaw() const { return raw; }
+};
+
+/* float, double and int operands are spelled out, so mixing them with Fixed
+	doesn't pick the builtin operator through operator float() */
+#define FIXED_ARITHMETIC(OP, A, B) \
+	inline Fixed operator OP(A a, B b) { Fixed r = a; r OP##= Fixed(b); return r; }
+#define FIXED_COMPARE(OP, A, B) \
+	inline bool operator OP(A a, B b) { return Fixed(a).getRaw() OP Fixed(b).getRaw(); }
+#define FIXED_OPERATORS(A, B) \
+	FIXED_ARITHMETIC(+, A, B) FIXED_ARITHMETIC(-, A, B) \
+	FIXED_ARITHMETIC(*, A, B) FIXED_ARITHMETIC(/, A, B) \
+	FIXED_COMPARE(==, A, B) FIXED_COMPARE(!=, A, B) FIXED_COMPARE(<, A, B) \
+	FIXED_COMPARE(<=, A, B) FIXED_COMPARE(>, A, B) FIXED_COMPARE(>=, A, B)
+
+FIXED_OPERATORS(const Fixed &, const Fixed &)
+FIXED_OPERATORS(const Fixed &, int)
+FIXED_OPERATORS(int, const Fixed &)
+FIXED_OPERATORS(const Fixed &, float)
+FIXED_OPERATORS(float, const Fixed &)
+FIXED_OPERATORS(const Fixed &, double)
+FIXED_OPERATORS(double, const Fixed &)
+
+#undef FIXED_OPERATORS
+#undef FIXED_COMPARE
+#undef FIXED_ARITHMETIC
+
+inline Fixed fabs(const Fixed &a) { return a < 0 ? -a : a; }
+inline Fixed floor(const Fixed &a) { return Fixed::fromRaw(a.getRaw() & ~(Fixed::ONE - 1)); }
+inline Fixed ceil(const Fixed &a) { return -floor(-a); }
+Fixed sqrt(const Fixed &a);
+/* in radians, like the float one, but only good to about 0.3 degrees */
+Fixed atan2(const Fixed &y, const Fixed &x);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef __FRAME_CAPTURE_H__
+#define __FRAME_CAPTURE_H__
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include "SDL.h"
+#include "SDL_thread.h"
+#include "image.h"
+
+/* writes frames to disk on a worker thread. frames go through a fixed
+	number of buffers: the caller fills a free one (beginFrame), hands it
+	over (endFrame), and the worker writes it and gives it back. when all
+	of them are waiting to be written, beginFrame either waits or skips the
+	frame, so a slow disk doesn't hold up the game.
+
+	frames are RGBA, top row first (what Renderer::readPixels gives). the
+	format comes from the file name:
+		.raw, .ppm, .png	one file per frame; the frame number goes where
+							the name has a %d, or before the extension
+		.y4m				one YUV 4:2:0 stream */
+class FrameCapture
+{
+/* types */
+public:
+	enum Format
+	{
+		RAW,
+		PPM,
+		PNG,
+		Y4M,
+		UNKNOWN
+	};
+
+/* fields */
+private:
+	Format format;
+	std::string pattern;
+	int width, height, fps;
+
+	/* frame buffers: ones that can be filled, and ones waiting to be
+		written, oldest first */
+	std::vector<Uint8 *> buffers;
+	std::vector<int> idle;
+	std::deque<int> queued;
+	int current;
+
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *wake, *done;
+	bool quit;
+
+	/* only used by the worker */
+	FILE *stream;
+	Image image;
+	std::vector<Uint8> encoded, plane;
+	int written;
+	bool failed;
+
+	int captured, skipped;
+
+/* constructors */
+public:
+	FrameCapture();
+	~FrameCapture();
+
+/* methods */
+private:
+	static int threadFunc(void *data);
+	void run();
+	bool write(const Uint8 *rgba);
+	bool writeFile(const char *name, const void *data, size_t size);
+	void encodePPM();
+	void encodePNG();
+	void encodeY4M(const Uint8 *rgba);
+
+public:
+	static Format getFormat(const char *file);
+
+	/* false if the format isn't known; fps only goes in Y4M headers */
+	bool start(const char *file, int _width, int _height, int _fps,
+		int numBuffers = 8);
+	/* writes everything that's queued, and stops the worker */
+	void stop();
+
+	/* a buffer for width x height RGBA pixels, or NULL if none is free
+		and wait is false */
+	Uint8 *beginFrame(bool wait);
+	void endFrame();
+	/* false once a write failed; nothing more is written after that */
+	bool isOK();
+
+/* getters */
+public:
+	bool isRunning() const { return thread != NULL; }
+	int getCaptured() const { return captured; }
+	int getSkipped() const { return skipped; }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef __FRAME_PACER_H__
+#define __FRAME_PACER_H__
+
+#include "SDL.h"
+
+/* starts frames on a fixed schedule, using getTime rather than
+	SDL_GetTicks. every frame has a deadline one period after the last
+	one's, so rounding doesn't add up; wait() sleeps until a little
+	before it, and spins for the rest, since SDL_Delay can oversleep by
+	a few milliseconds.
+
+	with vsync the swap already waits for the display, so the pacer only
+	waits when a frame is more than half a period early (on displays
+	faster than the game). a frame that's a whole period late gives up
+	on the schedule, rather than running the next frames back to back to
+	catch up */
+class FramePacer
+{
+/* types */
+public:
+	/* frame times (from one wait() returning to the next), in seconds */
+	struct Stats
+	{
+		int frames;
+		/* frames that started after their deadline */
+		int late;
+		double average, deviation, min, max;
+	};
+
+/* fields */
+private:
+	/* how much of the wait is spun instead of slept */
+	static const double SPIN_TIME;
+
+	double period;
+	bool vsync;
+	double deadline, lastStart;
+
+	int frames, late;
+	double sum, sumSquares, minTime, maxTime;
+
+/* constructors */
+public:
+	FramePacer(double _period);
+
+/* methods */
+private:
+	void clearStats();
+
+public:
+	/* asks the driver to sync swaps to the display; has to be called
+		before the video mode is set. use hasVsync afterward to find out
+		if it did */
+	static void requestVsync(bool on);
+	static bool hasVsync();
+
+	/* waits until the next frame is due */
+	void wait();
+	/* starts the schedule over, e.g. after the game was paused */
+	void reset();
+	/* the stats since the last call */
+	void takeStats(Stats &s);
+
+/* setters */
+public:
+	void setVsync(bool on) { vsync = on; }
+
+/* getters */
+public:
+	double getPeriod() const { return period; }
+};
+
+#endif
\ No newline at end of file
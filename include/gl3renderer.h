@@ -0,0 +1,46 @@
+#ifndef __GL3_RENDERER_H__
+#define __GL3_RENDERER_H__
+
+#include <vector>
+#include "renderer.h"
+
+/* GL 3.3 core: one shader program, a vertex buffer the vertices are
+	streamed into every draw, and an index buffer that turns quads into
+	triangles. the projection is a uniform.
+
+	SDL only makes compatibility contexts, so the functions past GL 1.1
+	are looked up with SDL_GL_GetProcAddress, and init fails if the
+	context is older than 3.3 */
+class GL3Renderer : public Renderer
+{
+/* fields */
+private:
+	int width, height;
+	GLuint program, vertexArray, vertexBuffer, indexBuffer;
+	/* quads the index buffer has room for */
+	int indexedQuads;
+	std::vector<GLuint> indices;
+
+/* constructors */
+public:
+	GL3Renderer(int _width, int _height);
+	~GL3Renderer();
+
+/* methods */
+private:
+	static bool loadFunctions();
+	GLuint compile(GLenum type, const char *source);
+	void reserveQuads(int quads);
+
+public:
+	bool init();
+	void clear();
+	void draw(Primitive type, GLuint texture, const SpriteVertex *v, int n,
+		bool blend);
+
+/* getters */
+public:
+	const char *getName() const { return "GL 3.3"; }
+};
+
+#endif
\ No newline at end of file
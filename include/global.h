@@ -3,6 +3,19 @@
 
 #include <algorithm>
 
+/* the numbers the simulation runs on. float, unless SIMFUN_FIXED_POINT is
+	defined: then they're fixed point (see fixed.h), and a simulation comes
+	out bit for bit the same with any compiler on any machine */
+#ifdef SIMFUN_FIXED_POINT
+#include "fixed.h"
+typedef Fixed real;
+#define REAL_MAX Fixed::max()
+#else
+#include <float.h>
+typedef float real;
+#define REAL_MAX FLT_MAX
+#endif
+
 /* surprisingly useful */
 template <class T>
 inline T clamp(const T &value, const T &low, const T &high)
@@ -0,0 +1,42 @@
+#ifndef __IMAGE_H__
+#define __IMAGE_H__
+
+#include "SDL.h"
+
+/* 24 bit RGB image, top row first, rows tightly packed. this is the layout
+	glTexImage2D wants (with GL_UNPACK_ALIGNMENT 1), so images are decoded
+	straight into it -- no SDL_Surface, blitting or flipping afterward */
+struct Image
+{
+/* fields */
+	int w, h;
+	Uint8 *pixels;
+
+/* constructors */
+	Image() : w(0), h(0), pixels(NULL) {}
+	Image(const Image &i);
+	~Image();
+
+/* methods */
+private:
+	bool decodeBMP(const Uint8 *data, unsigned int size, const char *file);
+	bool decodeRaw(const Uint8 *data, unsigned int size, const char *file);
+
+public:
+	Image &operator =(const Image &i);
+
+	bool create(int _w, int _h);
+	void fill(Uint8 value);
+	/* loads a .bmp (24 bit, uncompressed) or a raw image written by
+		saveRaw, determined by the file contents */
+	bool load(const char *file);
+	bool saveRaw(const char *file) const;
+
+	Uint8 *row(int j) { return pixels + j * w * 3; }
+	const Uint8 *row(int j) const { return pixels + j * w * 3; }
+
+	/* swaps red and blue of n pixels while copying them */
+	static void swizzle(Uint8 *dest, const Uint8 *src, int n);
+};
+
+#endif
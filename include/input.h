@@ -0,0 +1,150 @@
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <vector>
+#include "SDL.h"
+
+/* where the player's buttons (Player::InputFlags) come from, one tick at
+	a time */
+class InputSource
+{
+/* constructors */
+public:
+	virtual ~InputSource() {}
+
+/* methods */
+public:
+	/* the buttons for the next tick */
+	virtual int nextButtons() = 0;
+};
+
+/* the arrow keys and space. key events are queued as they arrive, and
+	each tick takes the ones that came in since the last, so a press that
+	is released before the next tick still counts for that tick. a second
+	press of the same button is left for the tick after, so Player sees it
+	as a new press */
+class KeyboardInput : public InputSource
+{
+/* types */
+private:
+	struct KeyEvent
+	{
+		/* getTime when it arrived */
+		double time;
+		int button;
+		bool down;
+	};
+
+/* fields */
+private:
+	/* events past this are applied right away, if nothing takes them */
+	static const unsigned int MAX_EVENTS = 64;
+
+	std::vector<KeyEvent> events;
+	int held;
+
+	/* time from events arriving to the tick that takes them */
+	double latencySum;
+	int latencyCount;
+
+/* constructors */
+public:
+	KeyboardInput(): held(0), latencySum(0), latencyCount(0) {}
+
+/* methods */
+private:
+	static int getButton(SDLKey key);
+
+public:
+	/* false if it's not a key for a button */
+	bool handleEvent(const SDL_Event &event);
+	/* lets go of everything, e.g. when the window loses focus and the
+		key ups won't come */
+	void reset();
+	int nextButtons();
+	/* average time events waited for a tick since the last call, in
+		seconds */
+	double takeLatency();
+};
+
+/* plays a list of steps, over and over */
+class ScriptInput : public InputSource
+{
+/* types */
+public:
+	struct Step
+	{
+		int ticks;
+		int buttons;
+		/* tap jump instead of holding it */
+		bool hop;
+	};
+
+/* fields */
+private:
+	const Step *steps;
+	int numSteps, length;
+	int tick;
+
+/* constructors */
+public:
+	ScriptInput(const Step *_steps, int _numSteps);
+
+/* methods */
+public:
+	int nextButtons();
+	void rewind() { tick = 0; }
+};
+
+/* passes the buttons of another source through, and keeps them, so they
+	can be saved for a ReplayInput. a replay only plays back the same way
+	if it starts from the same map and random state, and only the
+	player's buttons are kept -- not the other keys */
+class RecordInput : public InputSource
+{
+/* fields */
+private:
+	InputSource *source;
+	int map;
+	Uint32 randomState;
+	std::vector<Uint8> buttons;
+
+/* constructors */
+public:
+	/* map and randomState are what the game is starting from */
+	RecordInput(InputSource *_source, int _map, Uint32 _randomState):
+		source(_source), map(_map), randomState(_randomState) {}
+
+/* methods */
+public:
+	int nextButtons();
+	bool save(const char *file) const;
+};
+
+/* plays back what a RecordInput saved; no buttons after the end */
+class ReplayInput : public InputSource
+{
+/* fields */
+private:
+	int map;
+	Uint32 randomState;
+	std::vector<Uint8> buttons;
+	unsigned int tick;
+
+/* constructors */
+public:
+	ReplayInput(): map(0), randomState(1), tick(0) {}
+
+/* methods */
+public:
+	bool load(const char *file);
+	int nextButtons();
+
+/* getters */
+public:
+	int getMap() const { return map; }
+	Uint32 getRandomState() const { return randomState; }
+	bool isDone() const { return tick >= buttons.size(); }
+};
+
+#endif
\ No newline at end of file
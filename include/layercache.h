@@ -0,0 +1,46 @@
+#ifndef __LAYER_CACHE_H__
+#define __LAYER_CACHE_H__
+
+#include "SDL_opengl.h"
+#include "SDL.h"
+
+class Renderer;
+
+/* a copy of the layers that don't move (tiles, walls), so a frame can
+	start from it instead of drawing them again. the layers are drawn into
+	the back buffer once, and copied into a texture from there; that works
+	on GL 1.1, without framebuffer objects.
+
+	the copy has to be thrown away when anything in it changes: a new
+	level, reloaded images, or different layers turned on */
+class LayerCache
+{
+/* fields */
+private:
+	GLuint texture;
+	int width, height;
+	/* power of 2 size of the texture */
+	int texWidth, texHeight;
+	/* what's in the texture, or -1 if nothing */
+	int layers;
+
+/* constructors */
+public:
+	LayerCache(int _width, int _height);
+	~LayerCache();
+
+/* methods */
+public:
+	/* copies the back buffer (with the given layers drawn, and nothing
+		else yet) into the cache */
+	void capture(int _layers);
+	/* draws the cached layers over the whole screen */
+	void draw(Renderer &renderer) const;
+	void invalidate() { layers = -1; }
+
+/* getters */
+public:
+	bool isValid(int _layers) const { return layers == _layers; }
+};
+
+#endif
\ No newline at end of file
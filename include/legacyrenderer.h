@@ -0,0 +1,25 @@
+#ifndef __LEGACY_RENDERER_H__
+#define __LEGACY_RENDERER_H__
+
+#include "renderer.h"
+
+/* fixed function GL 1.x: client side vertex arrays, the projection in the
+	matrix stack, and GL_MODULATE for the colors */
+class LegacyRenderer : public Renderer
+{
+/* constructors */
+public:
+	LegacyRenderer(int width, int height);
+
+/* methods */
+public:
+	void clear();
+	void draw(Primitive type, GLuint texture, const SpriteVertex *v, int n,
+		bool blend);
+
+/* getters */
+public:
+	const char *getName() const { return "legacy"; }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef __LEVEL_H__
+#define __LEVEL_H__
+
+#include <deque>
+#include <stack>
+#include "arena.h"
+#include "tiles.h"
+#include "tilemap.h"
+#include "region.h"
+
+class Walls;
+class NavGraph;
+class Physics;
+
+/* everything built from a map file: the tile types, the TileMap, merged
+	walls and regions. a Level doesn't touch GL or the Simulation, so it
+	can be built on another thread and handed to Background when it's done.
+
+	all of it (down to the list nodes) is allocated from the level's arena,
+	so a load is a few big allocations, and deleting the level frees the
+	arena without destroying anything one by one.
+
+	the walls are built on up to getThreads() threads, and the regions are
+	filled on another one at the same time; the result is the same with
+	any number */
+class Level
+{
+/* types */
+private:
+	/* used for seed fill */
+	struct Strip
+	{
+		int xl, xr, y, dy;
+		Strip(int _xl, int _xr, int _y, int _dy):
+			xl(_xl), xr(_xr), y(_y), dy(_dy) {}
+	};
+
+	typedef std::stack<Strip, std::deque<Strip, Allocator<Strip> > > StripStack;
+
+/* fields */
+private:
+	static const size_t ARENA_BLOCK_SIZE;
+	static int threads;
+
+	Arena arena;
+	/* what the region fill allocates from, when it has its own thread */
+	Arena *fillArena;
+
+	Tile::TileType *map;
+	int tileWidth, tileHeight;
+
+	/* which region each tile was filled into, -1 for none; only used
+		while loading */
+	int *tileRegion;
+	int numRegions;
+	TileMap *tilemap;
+	Walls *walls;
+	Region::List *regions;
+	NavGraph *nav;
+
+/* constructors */
+public:
+	Level(int _tileWidth, int _tileHeight):
+		arena(ARENA_BLOCK_SIZE), fillArena(NULL),
+		map(NULL), tileWidth(_tileWidth), tileHeight(_tileHeight),
+		tileRegion(NULL), numRegions(0),
+		tilemap(NULL), walls(NULL), regions(NULL), nav(NULL) {}
+
+/* methods */
+private:
+	bool readMapFromFile(const char *file);
+	static int fillThread(void *data);
+	void fillRegions();
+	void mapRegions();
+	void clearTileRegion();
+	bool checkIndex(int i, int j, Tile::TileType type);
+	void paintIndex(int region, int i, int j);
+	void regionFill(int region, Tile::TileType type, int i, int j);
+
+public:
+	/* physics is only read here, so the loader thread can pass its own
+		copy while Physics::load changes the current one */
+	bool load(const char *file, const Physics &physics);
+	template <class T> T *allocate(size_t n = 1)
+	{
+		return (T *)arena.allocate(n * sizeof(T), AlignOf<T>::value);
+	}
+
+/* setters */
+public:
+	static void setThreads(int n) { threads = n < 1 ? 1 : n; }
+
+/* getters */
+public:
+	const Tile::TileType & mapIndex(int i, int j) const { return map[j*tileWidth+i]; }
+	Tile::TileType & mapIndex(int i, int j) { return map[j*tileWidth+i]; }
+	const TileMap & getTileMap() const { return *tilemap; }
+	TileMap & getTileMap() { return *tilemap; }
+	const Walls & getWalls() const { return *walls; }
+	Walls & getWalls() { return *walls; }
+	const NavGraph & getNavGraph() const { return *nav; }
+	int getTileWidth() const { return tileWidth; }
+	int getTileHeight() const { return tileHeight; }
+	Arena & getArena() { return arena; }
+	static int getThreads() { return threads; }
+};
+
+#endif
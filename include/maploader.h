@@ -0,0 +1,51 @@
+#ifndef __MAP_LOADER_H__
+#define __MAP_LOADER_H__
+
+#include <string>
+#include "SDL.h"
+#include "SDL_thread.h"
+#include "physics.h"
+
+class Level;
+
+/* builds Levels on a worker thread. only the newest request is kept; a
+	finished Level waits in the loader until the main thread picks it up
+	with poll(), between ticks. each request carries a copy of the physics
+	to build with, so the main thread can reload them meanwhile */
+class MapLoader
+{
+/* fields */
+private:
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *wake;
+	bool quit;
+
+	int tileWidth, tileHeight;
+
+	std::string requestFile;
+	int requestId;
+	Physics requestPhysics;
+	bool pending, working;
+
+	Level *result;
+	int resultId;
+
+/* constructors */
+public:
+	MapLoader(int _tileWidth, int _tileHeight);
+	~MapLoader();
+
+/* methods */
+private:
+	static int threadFunc(void *data);
+	void run();
+
+public:
+	void start();
+	void request(const char *file, int id, const Physics &physics);
+	Level *poll(int &id);
+	bool busy();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef __MEMORY_H__
+#define __MEMORY_H__
+
+#include <stddef.h>
+#include <new>
+
+/* where a container's memory comes from. the containers used for walls,
+	regions and collision take one (through Allocator), so the caller
+	decides: the heap, a Level's arena, or the per-frame arena */
+class MemoryResource
+{
+/* constructors */
+public:
+	virtual ~MemoryResource() {}
+
+/* methods */
+public:
+	/* throws std::bad_alloc when out of memory, like new does */
+	virtual void *allocate(size_t n, size_t align) = 0;
+	virtual void deallocate(void *p, size_t n) = 0;
+
+	/* new and delete; used when no resource is given */
+	static MemoryResource *getDefault();
+};
+
+/* alignment of T, without compiler extensions */
+template <class T>
+struct AlignOf
+{
+	struct S { char c; T t; };
+	enum { value = sizeof(S) - sizeof(T) };
+};
+
+/* STL allocator that takes its memory from a MemoryResource. containers
+	with different resources are still the same type */
+template <class T>
+class Allocator
+{
+/* types */
+public:
+	typedef T value_type;
+	typedef T *pointer;
+	typedef const T *const_pointer;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template <class U> struct rebind { typedef Allocator<U> other; };
+
+/* fields */
+public:
+	MemoryResource *resource;
+
+/* constructors */
+public:
+	Allocator(MemoryResource *_resource = NULL):
+		resource(_resource ? _resource : MemoryResource::getDefault()) {}
+	Allocator(const Allocator &a): resource(a.resource) {}
+	template <class U> Allocator(const Allocator<U> &a): resource(a.resource) {}
+
+/* methods */
+public:
+	pointer address(reference r) const { return &r; }
+	const_pointer address(const_reference r) const { return &r; }
+
+	pointer allocate(size_type n, const void * = 0)
+	{
+		return (pointer)resource->allocate(n * sizeof(T), AlignOf<T>::value);
+	}
+
+	void deallocate(pointer p, size_type n)
+	{
+		resource->deallocate(p, n * sizeof(T));
+	}
+
+	size_type max_size() const { return (size_type)-1 / sizeof(T); }
+	void construct(pointer p, const T &v) { new ((void *)p) T(v); }
+	void destroy(pointer p) { p->~T(); }
+};
+
+template <class T, class U>
+inline bool operator ==(const Allocator<T> &a, const Allocator<U> &b) { return a.resource == b.resource; }
+template <class T, class U>
+inline bool operator !=(const Allocator<T> &a, const Allocator<U> &b) { return a.resource != b.resource; }
+
+#endif
\ No newline at end of file
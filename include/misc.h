@@ -2,11 +2,18 @@
 #define __MISC_H__
 
 #include "SDL.h"
+#include "global.h"
 
-SDL_Surface *loadBMP(const char *filename);
-SDL_Surface *fixImage(SDL_Surface *src);
-SDL_Surface *makeTexture(SDL_Surface *src);
 void ErrorBox(const char *format,...);
-float frand();
+real frand();
+/* frand's state, so a saved simulation makes the same random numbers
+	again after it's restored */
+Uint32 getRandomState();
+void setRandomState(Uint32 state);
+/* seconds since some fixed point, with much better resolution than
+	SDL_GetTicks */
+double getTime();
+/* most memory the process has used so far, in bytes (0 if unknown) */
+long getPeakMemory();
 
 #endif
\ No newline at end of file
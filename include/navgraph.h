@@ -0,0 +1,160 @@
+#ifndef __NAV_GRAPH_H__
+#define __NAV_GRAPH_H__
+
+#include <vector>
+#include "memory.h"
+#include "point.h"
+#include "tiles.h"
+
+class Level;
+class Physics;
+
+/* how the level is connected, for a player: where one can stand, climb and
+	swim, and how to get from one to the other by walking, falling, jumping
+	(as far as Player's jump goes), climbing and swimming. it's built from
+	the tile types when the level is loaded.
+
+	all of it, including the path cache and the memory A* works in, is
+	allocated from the level's arena when it's built, so a query doesn't
+	allocate. queries share that memory, so only one thread can make them */
+class NavGraph
+{
+/* types */
+public:
+	enum NodeType
+	{
+		STAND,
+		CLIMB,
+		SWIM
+	};
+
+	/* how to get to a node from the one before it */
+	enum LinkType
+	{
+		START,
+		WALK,
+		FALL,
+		JUMP,
+		LADDER,
+		WATER
+	};
+
+	struct Waypoint
+	{
+		Point pos;
+		NodeType type;
+		LinkType link;
+	};
+
+	typedef std::vector<Waypoint> Path;
+
+private:
+	struct Node
+	{
+		/* where the player's center is */
+		Point pos;
+		NodeType type;
+		int i, j;
+		/* edges[firstEdge] to edges[firstEdge+numEdges-1] */
+		int firstEdge, numEdges;
+	};
+
+	struct Edge
+	{
+		int from, to;
+		real cost;
+		LinkType link;
+
+		bool operator <(const Edge &e) const { return from < e.from; }
+	};
+
+	struct CacheEntry
+	{
+		int start, goal;
+		/* number of edges, or -1 if there's no path */
+		int length;
+	};
+
+	/* open list entry */
+	struct Open
+	{
+		real f, cost;
+		int node;
+
+		bool operator <(const Open &o) const { return f > o.f; }
+	};
+
+	typedef std::vector<int, Allocator<int> > IntVector;
+
+/* fields */
+private:
+	static const int CACHE_SIZE = 256;
+	/* longer paths aren't cached */
+	static const int MAX_CACHED_PATH = 64;
+	static const int JUMP_TICKS = 120;
+	static const real JUMP_COST;
+
+	int tileWidth, tileHeight;
+	const Level *level;
+
+	std::vector<Node, Allocator<Node> > nodes;
+	std::vector<Edge, Allocator<Edge> > edges;
+	/* node at each tile, or -1: one table for standing, one for the rest */
+	IntVector standAt, otherAt;
+
+	/* A* state, by node. a node's entries are only valid if its stamp is
+		the current search's */
+	mutable std::vector<real, Allocator<real> > cost;
+	mutable IntVector via;
+	mutable std::vector<unsigned int, Allocator<unsigned int> > stamp;
+	mutable std::vector<Open, Allocator<Open> > open;
+	mutable unsigned int searchStamp;
+
+	/* edges of the cached paths, MAX_CACHED_PATH per entry */
+	mutable std::vector<CacheEntry, Allocator<CacheEntry> > cache;
+	mutable IntVector cachePaths;
+
+	mutable int queries, cacheHits;
+
+/* constructors */
+public:
+	NavGraph(MemoryResource *resource = NULL);
+
+/* methods */
+private:
+	Tile::TileType tileAt(int i, int j) const;
+	bool isOpen(int i, int j) const;
+	bool blocks(int i, int j) const;
+	bool blocksAt(real x, real y) const;
+	/* a one way wall in the way of going left (di < 0) or right */
+	bool blocksSide(int i, int j, int di) const;
+	bool isFloor(int i, int j) const;
+	bool isClear(int l, int t, int r, int b) const;
+	bool canStand(int i, int j) const;
+	bool canMove(int i, int j) const;
+	int addNode(int i, int j, NodeType type, const Point &pos);
+	void addEdge(int from, int to, LinkType link, real costScale = 1);
+	void addWalks(int from);
+	void addJumps(int from, const Vector *arc, real apex);
+	bool canJump(const Node &from, const Node &to, const Vector *arc, real apex) const;
+	bool search(int start, int goal) const;
+
+public:
+	/* the jumps are the ones physics allows */
+	void build(const Level &_level, const Physics &physics);
+	/* the node a player at p is on, or -1 */
+	int findNode(const Point &p) const;
+	/* shortest way from one point to another, start and goal included.
+		false if either isn't on the graph, or there's no way */
+	bool findPath(const Point &from, const Point &to, Path &path) const;
+
+/* getters */
+public:
+	int getNumNodes() const { return nodes.size(); }
+	int getNumEdges() const { return edges.size(); }
+	const Point & getNodePos(int n) const { return nodes[n].pos; }
+	int getQueries() const { return queries; }
+	int getCacheHits() const { return cacheHits; }
+};
+
+#endif
\ No newline at end of file
@@ -6,16 +6,41 @@
 #include "wall.h"
 
 class Background;
+class SegmentBatch;
+class Snapshot;
+class SpriteBatch;
+class TileMap;
+class WallSet;
 
 class Object
 {
+/* types */
+public:
+	/* tiles touched by the object's bounding circle, [l,r) x [t,b) */
+	struct TileBounds
+	{
+		int l, r, t, b;
+
+		bool operator ==(const TileBounds &o) const
+		{
+			return l == o.l && r == o.r && t == o.t && b == o.b;
+		}
+		bool operator <(const TileBounds &o) const
+		{
+			if (t != o.t) return t < o.t;
+			if (l != o.l) return l < o.l;
+			if (b != o.b) return b < o.b;
+			return r < o.r;
+		}
+	};
+
 /* fields */
 protected:
 	Point pos;
 	Point oldPos;
 	Vector scale;
 	Vector size;
-	float radius;
+	real radius;
 	Vector normal;
 	int normalCount;
 
@@ -27,14 +52,25 @@ public:
 	Object(const Object &o);
 
 /* methods */
+private:
+	static MemoryResource *ignorePool();
+
 public:
-	virtual void draw() = 0;
+	virtual void draw(SpriteBatch &batch) = 0;
 	virtual void update() = 0;
 	virtual void doCollision(Background &bg);
+	/* batch is the packed segments of the level the walls are from */
+	void collideWalls(const SegmentBatch &batch, const WallSet &set);
+	TileBounds getTileBounds() const;
+	static void gatherWalls(const TileMap &tilemap, const TileBounds &tb, WallSet &set);
 	virtual void preProcessWall(const Wall &w) {}
 	virtual bool processWall(const Wall &w);
 	void collideWall(const Segment &s);
 	void addNormal(const Vector &n);
+	/* the ignore list points at walls; call this when they go away */
+	void clearIgnore() { ignore.clear(); }
+	virtual void save(Snapshot &s) const;
+	virtual void restore(Snapshot &s);
 
 /* setters */
 public:
@@ -42,7 +78,7 @@ public:
 	void setOldPos(Point _oldPos) { oldPos = _oldPos; }
 	void setScale(Vector _scale) { scale = _scale; }
 	void setSize(Vector _size) { size = _size; }
-	void setRadius(float _radius) { radius = _radius; }
+	void setRadius(real _radius) { radius = _radius; }
 
 /* getters */
 public:
@@ -50,7 +86,7 @@ public:
 	Point & getOldPos() { return oldPos; }
 	Vector & getScale() { return scale; }
 	Vector & getSize() { return size; }
-	float getRadius() { return radius; }
+	real getRadius() { return radius; }
 	Vector & getNormal() { return normal; }
 };
 
@@ -4,6 +4,7 @@
 #include <list>
 #include "SDL_opengl.h"
 #include "SDL.h"
+#include "arena.h"
 #include "color.h"
 #include "object.h"
 
@@ -37,10 +38,12 @@ public:
 /* methods */
 public:
 	static Particle make(ParticleType _type, const Point &pos, const Vector &vel, 
-		const Color &_color, float _scale, int _lifetime);
-	void draw();
+		const Color &_color, real _scale, int _lifetime);
+	void draw(SpriteBatch &batch);
 	void update();
 	bool processWall(const Wall &w);
+	void save(Snapshot &s) const;
+	void restore(Snapshot &s);
 	bool alive() { return lifetime > 0; }
 
 /* setters */
@@ -54,22 +57,35 @@ struct Vector;
 
 class Particles
 {
+/* types */
+private:
+	typedef std::list<Particle, Allocator<Particle> > List;
+
 /* fields */
 private:
-	std::list<Particle> particles;
+	static const size_t POOL_BLOCK_SIZE;
+
+	/* particles come and go all the time; their list nodes are recycled
+		here instead of going back to the heap */
+	Arena pool;
+	List particles;
 
 /* constructors */
 public:
-	Particles() {}
+	Particles(): pool(POOL_BLOCK_SIZE), particles(List::allocator_type(&pool)) {}
 
 /* methods */
 public:
-	void draw();
+	void draw(SpriteBatch &batch);
 	void update();
 
 	void skidDust(const Point &p, const Vector &v);
 	void waterSplash(const Point &p, const Vector &v);
 	void add(const Particle &p) { particles.push_back(p); }
+	void clear() { particles.clear(); }
+	int size() const { return particles.size(); }
+	void save(Snapshot &s) const;
+	void restore(Snapshot &s);
 };
 
 #endif
\ No newline at end of file
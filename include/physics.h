@@ -0,0 +1,105 @@
+#ifndef __PHYSICS_H__
+#define __PHYSICS_H__
+
+#include "global.h"
+
+#if defined(_MSC_VER)
+#define CACHE_ALIGNED __declspec(align(64))
+#else
+#define CACHE_ALIGNED __attribute__((aligned(64)))
+#endif
+
+/* the numbers that decide how the player and particles move. they're read
+	from a file, and read again whenever it changes, so they can be tuned
+	while the game runs. the defaults are the values the game shipped with.
+
+	what the update loops read every tick is packed into one cache line each;
+	the things that only matter when something happens (a jump, water, a
+	splash) are kept apart */
+class Physics
+{
+/* types */
+public:
+	/* read by Player::move and settle every tick; exactly 64 bytes (two
+		cache lines in fixed point) */
+	struct CACHE_ALIGNED PlayerMotion
+	{
+		real drag;
+		real gravity, airborneGravity, jumpGravity;
+		real accel, airAccel, skidAccel;
+		real skidMultiplier, skidMaxAngle, skidFriction;
+		real velMaxX, velMaxY, velMin;
+		real maxRot;
+		int maxJumpTime, jumpMaxAirborneTime;
+	};
+
+	/* read by Particle::update every tick */
+	struct CACHE_ALIGNED ParticleMotion
+	{
+		real dustGravity, dropGravity;
+		real drag, velMax;
+	};
+
+	/* jumping, ladders and water */
+	struct PlayerActions
+	{
+		real jumpVelScale, jumpThrust, jumpYBias, airborneJumpThrust;
+		real climbFrictionX, climbFrictionY;
+		real waterGravity, waterAccel, waterThrust;
+		real dripGravity;
+		int ticksPerDrip, wetTime;
+	};
+
+	/* how many particles a burst makes (per unit of speed), how fast they
+		go and how long they last */
+	struct Burst
+	{
+		real count, vectorScale, lifetimeScale;
+	};
+
+	struct ParticleEffects
+	{
+		Burst skidDust, waterSplash;
+		/* a drop hitting a wall breaks into dropParts smaller ones, pushed
+			out along the wall normal */
+		Burst dropBreak;
+		real dropNormalScale;
+	};
+
+private:
+	struct Field
+	{
+		const char *name;
+		real *f;
+		int *i;
+	};
+
+/* fields */
+public:
+	PlayerMotion player;
+	ParticleMotion particle;
+	PlayerActions playerActions;
+	ParticleEffects particleEffects;
+
+private:
+	static Physics current;
+
+/* constructors */
+public:
+	Physics();
+
+/* methods */
+private:
+	int getFields(Field *fields);
+
+public:
+	/* reads the file over the current values; names it doesn't mention
+		keep theirs. on any error nothing changes */
+	static bool load(const char *file);
+
+/* getters */
+public:
+	static const Physics & get() { return current; }
+};
+
+#endif
\ No newline at end of file
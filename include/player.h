@@ -5,8 +5,11 @@
 #include "SDL_opengl.h"
 #include "SDL.h"
 #include "object.h"
+#include "physics.h"
 
+class Atlas;
 class Background;
+class WallSet;
 
 class Player : public Object
 {
@@ -36,40 +39,9 @@ private:
 
 /* fields */
 private:
-	static const float DRAG;
-	static const float GRAVITY;
-	static const float AIRBORNE_GRAVITY;
-	static const float WATER_GRAVITY;
-	static const float JUMP_GRAVITY;
-	static const float DRIP_GRAVITY;
-	static const float ACCEL;
-	static const float AIR_ACCEL;
-	static const float SKID_ACCEL;
-	static const float WATER_ACCEL;
-	static const float WATER_THRUST;
-	static const float SKID_MULTIPLIER;
-	static const float SKID_MAX_ANGLE;
-	static const float SKID_FRICTION;
-	static const float CLIMB_FRICTION_X;
-	static const float CLIMB_FRICTION_Y;
-	static const float JUMP_VEL_SCALE;
-	static const float JUMP_THRUST;
-	static const float JUMP_Y_BIAS;
-	static const float AIRBORNE_JUMP_THRUST;
-	static const float VEL_MAX_X;
-	static const float VEL_MAX_Y;
-	static const float VEL_MIN;
-	static const float MAX_ROT;
-	static const int MAX_JUMP_TIME;
-	static const int TICKS_PER_DRIP;
-	static const int JUMP_MAX_AIRBORNE_TIME;
-	static const int WET_TIME;
+	int sprite;
 
-private:
-	SDL_Surface *image;
-	GLuint texture;
-
-	float angle, skidAngle;
+	real angle, skidAngle;
 	unsigned int flags;
 	int jumpTime, airborneTime, wetTime;
 
@@ -81,13 +53,26 @@ public:
 
 /* methods */
 public:
-	void draw();
+	void draw(SpriteBatch &batch);
 	void update();
+	/* update() in three steps, so Agents can do the collision of many
+		players at once: move() handles input and moves the player,
+		settle() turns it to the ground after collision */
+	void move();
+	void settle();
 	void doCollision(Background &bg);
+	void doCollision(Background &bg, const WallSet &walls);
 	void preProcessWall(const Wall &w);
 	bool processWall(const Wall &w);
-	void getInput(Uint8 *keys);
-	void loadImage(const char *file);
+	/* where a running jump to the right, from flat ground and holding jump
+		the whole time, puts the player after each tick (relative to where
+		it started; y is down), with the given physics. used by NavGraph
+		to find what can be reached */
+	static void getJumpArc(const Physics &physics, Vector *arc, int ticks);
+	void setInput(int buttons);
+	void save(Snapshot &s) const;
+	void restore(Snapshot &s);
+	void loadImage(Atlas &atlas, const char *file);
 
 /* setters */
 public:
@@ -98,7 +83,7 @@ public:
 
 /* getters */
 public:
-	bool inJumpBias()	{ return airborneTime < JUMP_MAX_AIRBORNE_TIME; }
+	bool inJumpBias()	{ return airborneTime < Physics::get().player.jumpMaxAirborneTime; }
 	bool isAirborne()	{ return ((flags & IS_AIRBORNE) != 0); }
 	bool isJumping()	{ return ((flags & IS_JUMPING) != 0); }
 	bool isSkidding()	{ return ((flags & IS_SKIDDING) != 0); }
@@ -107,6 +92,7 @@ public:
 	bool inWater()		{ return ((flags & IN_WATER) != 0); }
 	bool underWater()	{ return ((flags & UNDER_WATER) != 0); }
 	bool isWet()		{ return wetTime > 0; }
+	int getButtons() const	{ return input; }
 };
 
 #endif
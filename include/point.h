@@ -10,18 +10,18 @@ struct Vector;
 struct Point
 {
 /* fields */
-	float x, y;
+	real x, y;
 
 /* constructors */
 	Point() : x(0), y(0) {}
-	Point(float _x, float _y) : x(_x), y(_y) {}
+	Point(real _x, real _y) : x(_x), y(_y) {}
 	Point(const Vector &v);
 
 /* methods */
 	Point &operator +=(const Vector &a);
 	Point &operator -=(const Vector &a);
 
-	static float dist(const Point &a, const Point &b);
+	static real dist(const Point &a, const Point &b);
 };
 
 inline Point operator +(const Point &a, const Vector &b) { Point r = a; r += b; return r; }
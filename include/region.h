@@ -3,6 +3,7 @@
 
 #include "circle.h"
 #include "point.h"
+#include "segmentbatch.h"
 #include "tiles.h"
 #include "wallset.h"
 
@@ -17,7 +18,7 @@ public:
 		CONTAIN
 	};
 
-	typedef std::list<Region> List;
+	typedef std::list<Region, Allocator<Region> > List;
 	typedef List::iterator ListIterator;
 	typedef List::const_iterator ListConstIterator;
 
@@ -25,15 +26,20 @@ public:
 private:
 	Tile::TileType type;
 	WallSet walls;
+	/* the walls again, for intersect; see buildBatch */
+	SegmentBatch batch;
 
 /* constructors */
 public:
-	Region(Tile::TileType _type): type(_type) {}
+	Region(Tile::TileType _type, MemoryResource *resource = NULL):
+		type(_type), walls(resource), batch(resource) {}
 
 /* methods */
 public:
 	void addWall(const Wall &w) { walls.add(w); }
 	void addFromTile(const TileMapEntry *tme) { walls.addFromTile(tme); }
+	/* call once all the walls are added */
+	void buildBatch();
 	bool contains(const Point &p) const;
 	IntersectType intersect(const Circle &c) const;
 
@@ -0,0 +1,68 @@
+#ifndef __RENDERER_H__
+#define __RENDERER_H__
+
+#include "SDL_opengl.h"
+#include "SDL.h"
+#include "color.h"
+
+/* interleaved vertex: position in screen pixels, texture coordinates and
+	a color the texture is multiplied by */
+struct SpriteVertex
+{
+	float x, y;
+	float u, v;
+	Color color;
+};
+
+/* everything the game draws goes through here: textured, colored quads
+	and lines in screen pixels, upper left at 0,0. the legacy backend uses
+	fixed function GL 1.x; the GL3 backend only uses what's in the 3.3 core
+	profile (shaders, buffers, vertex arrays), which is what software
+	rasterizers and newer drivers do well */
+class Renderer
+{
+/* types */
+public:
+	enum Backend
+	{
+		/* GL3 if the context supports it, else legacy */
+		AUTO,
+		LEGACY,
+		GL3
+	};
+
+	enum Primitive
+	{
+		/* 4 vertices per quad, in clockwise order */
+		QUADS,
+		LINES
+	};
+
+/* constructors */
+public:
+	virtual ~Renderer() {}
+
+/* methods */
+public:
+	/* makes a renderer for the current GL context, with the screen set up
+		for width x height pixels; NULL (after telling the user) if the
+		backend can't run on it */
+	static Renderer *create(Backend backend, int width, int height);
+
+	virtual void clear() = 0;
+	/* n vertices, modulated by texture; alpha blended if blend is set */
+	virtual void draw(Primitive type, GLuint texture, const SpriteVertex *v,
+		int n, bool blend) = 0;
+	/* called when everything in the frame has been drawn */
+	virtual void finish() {}
+	/* copies the finished frame into rgba (4 bytes per pixel, top row
+		first); the GL backends read the back buffer, so this goes before
+		the swap */
+	virtual void readPixels(Uint8 *rgba, int width, int height);
+
+/* getters */
+public:
+	virtual const char *getName() const = 0;
+};
+
+#endif
\ No newline at end of file
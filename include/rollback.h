@@ -0,0 +1,125 @@
+#ifndef __ROLLBACK_H__
+#define __ROLLBACK_H__
+
+#include <deque>
+#include <vector>
+#include "snapshot.h"
+
+/* one player's buttons for one tick */
+struct InputMessage
+{
+	int player;
+	int tick;
+	int buttons;
+};
+
+/* carries inputs between the players. messages must arrive in order (as
+	they would over TCP, or UDP with a reliability layer) */
+class Transport
+{
+/* constructors */
+public:
+	virtual ~Transport() {}
+
+/* methods */
+public:
+	virtual void send(const InputMessage &m) = 0;
+	virtual bool receive(InputMessage &m) = 0;
+};
+
+/* for testing without a network: everything sent comes back 'latency'
+	ticks later as the input of another player, so that player copies the
+	local one with a delay */
+class LoopbackTransport : public Transport
+{
+/* fields */
+private:
+	std::deque<InputMessage> queue;
+	int remotePlayer;
+	int latency;
+	int now;
+
+/* constructors */
+public:
+	LoopbackTransport(int _remotePlayer, int _latency):
+		remotePlayer(_remotePlayer), latency(_latency), now(-1) {}
+
+/* methods */
+public:
+	void send(const InputMessage &m);
+	bool receive(InputMessage &m);
+	void clear() { queue.clear(); now = -1; }
+
+/* setters */
+public:
+	void setLatency(int _latency) { latency = _latency; }
+};
+
+/* runs the simulation ahead of the other players' inputs. their buttons
+	are predicted (the last ones received are held), and when a real input
+	turns out different, the simulation is restored to the tick it belongs
+	to and run forward again. the state before every tick is kept in a
+	ring buffer, so a rollback can go back up to MAX_TICKS-1 ticks */
+class Rollback
+{
+/* types */
+public:
+	enum
+	{
+		MAX_PLAYERS = 4,
+		MAX_TICKS = 32
+	};
+
+private:
+	struct Frame
+	{
+		int inputs[MAX_PLAYERS];
+		/* one bit per player whose input is real, not predicted */
+		int confirmed;
+		/* the state before this tick was simulated */
+		Snapshot state;
+	};
+
+/* fields */
+private:
+	Frame frames[MAX_TICKS];
+	std::vector<InputMessage> early;
+	Transport *transport;
+
+	int numPlayers, localPlayer;
+	int tick;
+	/* newest input received from each player, and its tick */
+	int lastInput[MAX_PLAYERS];
+	int lastTick[MAX_PLAYERS];
+
+	int rollbacks, resimulated, stalls;
+
+/* constructors */
+public:
+	Rollback();
+
+/* methods */
+private:
+	Frame &frame(int t) { return frames[t % MAX_TICKS]; }
+	void receive(int &rollbackTo);
+	void predict(Frame &f);
+	void simulate(int t, bool save);
+
+public:
+	void start(int _numPlayers, int _localPlayer, Transport *_transport);
+	void stop() { transport = NULL; }
+	/* simulates one tick with the local player's buttons. returns false
+		if the other players are so far behind that the tick couldn't be
+		simulated without losing the ability to roll back */
+	bool advance(int buttons);
+
+/* getters */
+public:
+	bool isRunning() const { return transport != NULL; }
+	int getTick() const { return tick; }
+	int getRollbacks() const { return rollbacks; }
+	int getResimulated() const { return resimulated; }
+	int getStalls() const { return stalls; }
+};
+
+#endif
\ No newline at end of file
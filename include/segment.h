@@ -2,6 +2,7 @@
 #define __SEGMENT_H__
 
 #include <list>
+#include "memory.h"
 #include "point.h"
 #include "vector.h"
 #include "circle.h"
@@ -18,7 +19,7 @@ public:
 		SEGMENT
 	};
 
-	typedef std::list<Segment> List;
+	typedef std::list<Segment, Allocator<Segment> > List;
 	typedef List::iterator ListIterator;
 	typedef List::const_iterator ListConstIterator;
 
@@ -34,13 +35,16 @@ public:
 	{
 		normal.normalize();
 	}
+	/* when the normal is already known (see GridEdge) */
+	Segment(const Point &_p0, const Point &_p1, const Vector &_normal) :
+		p0(_p0), p1(_p1), normal(_normal) {}
 
 /* methods */
 private:
 	/* used by intersect(const Segment...) ... not stand-alone */
 	bool contains(const Point &p) const;
 public:
-	float dist(const Point &p) const;
+	real dist(const Point &p) const;
 	Point closestPoint(const Point &p) const;
 	bool intersect(const Circle &c) const;
 	IntersectType intersect(const Segment &s, Point &p0, Point &p1) const;
@@ -0,0 +1,79 @@
+#ifndef __SEGMENT_BATCH_H__
+#define __SEGMENT_BATCH_H__
+
+#include <vector>
+#include "memory.h"
+#include "segment.h"
+#include "circle.h"
+
+/* segments packed four at a time, field by field (four x0s, four y0s, ...),
+	so a circle is tested against four segments at once with SSE (in fixed
+	point, see global.h, one at a time). gives exactly the same answers as
+	Segment::intersect(const Circle &), since both compare squared
+	distances and compute them the same way.
+
+	packing costs more than the test saves, so a batch should be built once
+	and tested many times: Walls keeps one for the whole level, and each
+	Region one for its own walls */
+class SegmentBatch
+{
+/* types */
+public:
+	typedef std::vector<real, Allocator<real> > RealVector;
+	/* one bit per segment, in the order they were added */
+	typedef std::vector<unsigned int, Allocator<unsigned int> > Mask;
+
+private:
+	enum Field { X0, Y0, X1, Y1, DX, DY, LEN2, NUM_FIELDS };
+
+/* fields */
+private:
+	static const int LANES = 4;
+	static const int GROUP_SIZE = LANES * NUM_FIELDS;
+
+	RealVector data;
+	Mask mask;
+	int count;
+
+/* constructors */
+public:
+	SegmentBatch(MemoryResource *resource = NULL):
+		data(RealVector::allocator_type(resource)),
+		mask(Mask::allocator_type(resource)), count(0) {}
+
+/* methods */
+private:
+	static int intersectGroup(const real *group, const Circle &c);
+
+public:
+	void clear();
+	void reserve(int n);
+	void add(const Segment &s);
+
+	/* sets the mask bit of every segment that intersects the circle, and
+		returns how many do */
+	int intersect(const Circle &c);
+	/* the same, for several circles: a segment's bit is set if it
+		intersects any of them */
+	int intersect(const Circle *circles, int n);
+	/* stops at the first hit; doesn't touch the mask */
+	bool intersectAny(const Circle &c) const;
+	/* tests only segments getGroup(i)*4 to getGroup(i)*4+3, and returns a
+		bit for each; segment i is bit getLane(i). doesn't touch the mask */
+	int intersectGroup(int group, const Circle &c) const
+	{
+		return intersectGroup(&data[group * GROUP_SIZE], c);
+	}
+
+	static int getGroup(int i) { return i / LANES; }
+	static int getLane(int i) { return i % LANES; }
+
+/* getters */
+public:
+	int size() const { return count; }
+	bool empty() const { return count == 0; }
+	bool hit(int i) const { return (mask[i >> 5] >> (i & 31)) & 1; }
+	const Mask & getMask() const { return mask; }
+};
+
+#endif
\ No newline at end of file
@@ -1,9 +1,24 @@
 #ifndef __SIMULATION_H__
 #define __SIMULATION_H__
 
+#include <vector>
+#include "agents.h"
+#include "alloctrack.h"
+#include "arena.h"
+#include "atlas.h"
 #include "background.h"
+#include "framecapture.h"
+#include "framepacer.h"
+#include "input.h"
+#include "layercache.h"
+#include "maploader.h"
 #include "player.h"
 #include "particle.h"
+#include "renderer.h"
+#include "rollback.h"
+#include "snapshot.h"
+#include "spritebatch.h"
+#include "watcher.h"
 
 class Simulation
 {
@@ -14,18 +29,83 @@ public:
 		DRAW_TILES = 1,
 		DRAW_WALLS = 2,
 		DRAW_PLAYER = 4,
-		DRAW_PARTICLES = 8
+		DRAW_PARTICLES = 8,
+		/* keep the tiles and walls in a LayerCache, and only draw the
+			things that move */
+		DRAW_CACHED = 16
+	};
+
+	/* watcher ids; maps are watched with their index in mapData */
+	enum Assets
+	{
+		IMAGE_ASSET = -1,
+		PHYSICS_ASSET = -2
+	};
+
+	/* what each part of a step() took, for bench. allocs is what happened
+		under that part's AllocTracker tag, so it's only counted in a build
+		with SIMFUN_TRACK_ALLOCS */
+	struct PhaseTimes
+	{
+		enum Phase
+		{
+			PLAYER,
+			AGENTS,
+			PARTICLES,
+			NUM_PHASES
+		};
+
+		double time[NUM_PHASES];
+		AllocTracker::Stats allocs[NUM_PHASES];
+
+		static AllocTracker::Tag getTag(int phase);
 	};
 
 /* consts */
 private:
 	static const int FRAME_RATE;
+	static const char *CAPTION;
+	static const int AGENTS_PER_SPAWN;
+	static const Uint32 SNAPSHOT_MAGIC;
+	static const int LOOPBACK_LATENCY;
+	static const size_t FRAME_ARENA_SIZE;
 
 /* fields */
 private:
+	Atlas atlas;
+	Renderer *renderer;
+	SpriteBatch batch;
+	LayerCache layerCache;
+	FrameCapture capture;
+	FramePacer pacer;
+	/* frame times go in the window caption */
+	bool showStats;
+	double statsTime;
+
 	Background bg;
 	Player player;
+	Agents agents;
 	Particles particles;
+	/* for things that only live during one tick, like collision queries;
+		reset at the start of every tick */
+	Arena frameArena;
+
+	KeyboardInput keyboard;
+	/* the player's buttons; the keyboard unless it's been set */
+	InputSource *input;
+
+	MapLoader mapLoader;
+	AssetWatcher watcher;
+	std::vector<int> changedAssets;
+	int currentMap, requestedMap;
+	bool respawn;
+	/* bumped every time the level is swapped, so old snapshots aren't
+		restored onto different walls */
+	int levelSerial;
+	Snapshot quickSave;
+
+	Rollback rollback;
+	LoopbackTransport loopback;
 
 	int flags;
 
@@ -35,24 +115,77 @@ public:
 
 /* constructor */
 private:
-	Simulation(): flags(DRAW_TILES | DRAW_PLAYER | DRAW_PARTICLES) {}
+	Simulation():
+		renderer(NULL),
+		batch(atlas),
+		layerCache(640, 480),
+		pacer(1.0 / FRAME_RATE), showStats(false), statsTime(0),
+		frameArena(FRAME_ARENA_SIZE),
+		input(&keyboard),
+		mapLoader(bg.getTileWidth(), bg.getTileHeight()),
+		currentMap(-1), requestedMap(-1), respawn(false), levelSerial(0),
+		loopback(1, LOOPBACK_LATENCY),
+		flags(DRAW_TILES | DRAW_PLAYER | DRAW_PARTICLES) {}
 
 /* methods */
 private:
 	void draw();
 	void update();
 	void loadMap(int map);
+	void checkAssets();
+	void checkLoader();
+	void setLevel(Level *level, int map);
+	void spawnAgents();
+	void toggleLoopback();
+	void toggleFrameStats();
+	void showFrameStats();
 
 public:
-	void initGraphics();
+	/* everything that changes while the simulation runs (player, agents,
+		particles, random numbers), but not the level itself */
+	void saveState(Snapshot &s) const;
+	bool restoreState(Snapshot &s);
+	/* one tick of the simulation. inputs[0] is the player's buttons, and
+		inputs[i] the buttons of agent i-1; agents without one copy the
+		player. if times isn't NULL, each part of the tick is timed into it */
+	void step(const int *inputs, int count, PhaseTimes *times = NULL);
+
+	/* loads a map on this thread, and puts the player at its start */
+	void loadMapNow(int map);
+
+	/* vsync is only a request; drivers can ignore it */
+	void initGraphics(Renderer::Backend backend = Renderer::AUTO, bool vsync = true);
+	/* the images, packed into the atlas; upload is false when there's no
+		GL context, for a SoftRenderer */
+	void loadImages(bool upload = true);
 	void initData();
+	/* draws the current state, without showing it */
+	void render();
+	/* writes every frame shown to file, from now until mainLoop ends
+		(see FrameCapture for the formats) */
+	bool startCapture(const char *file);
 	void mainLoop();
 
+/* setters */
+public:
+	/* everything is drawn through r, which the caller keeps */
+	void setRenderer(Renderer *r);
+	/* the player's buttons come from source, which the caller keeps; NULL
+		goes back to the keyboard */
+	void setInput(InputSource *source) { input = source ? source : &keyboard; }
+
 /* getters */
 public:
+	static int getNumMaps();
+	static const char *getMapName(int map);
+	const Atlas & getAtlas() const { return atlas; }
+	int getCurrentMap() const { return currentMap; }
+	KeyboardInput & getKeyboard() { return keyboard; }
 	Background & getBackground() { return bg; }
 	Player & getPlayer() { return player; }
+	Agents & getAgents() { return agents; }
 	Particles & getParticles() { return particles; }
+	Arena & getFrameArena() { return frameArena; }
 };
 
 #endif
\ No newline at end of file
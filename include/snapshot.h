@@ -0,0 +1,53 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <vector>
+#include "SDL.h"
+#include "wall.h"
+
+class Walls;
+
+/* flat binary copy of the dynamic state of the simulation. it's just a byte
+	buffer that values are appended to and read back from in the same order,
+	so saving and restoring are a few memcpys. walls are written as their
+	index in Walls, so a snapshot can only be restored on the level it was
+	taken on */
+class Snapshot
+{
+/* fields */
+private:
+	std::vector<Uint8> data;
+	unsigned int readPos;
+	bool overrun;
+	const Walls *walls;
+
+/* constructors */
+public:
+	Snapshot(): readPos(0), overrun(false), walls(NULL) {}
+
+/* methods */
+public:
+	/* start writing; the buffer keeps its capacity, so saving every frame
+		doesn't allocate */
+	void clear(const Walls *_walls);
+	/* start reading from the beginning */
+	void rewind(const Walls *_walls);
+
+	void write(const void *p, unsigned int n);
+	bool read(void *p, unsigned int n);
+
+	template <class T> void put(const T &v) { write(&v, sizeof(T)); }
+	template <class T> bool get(T &v) { return read(&v, sizeof(T)); }
+
+	void putWalls(const Wall::CPList &list);
+	bool getWalls(Wall::CPList &list);
+
+/* getters */
+public:
+	bool empty() const { return data.empty(); }
+	unsigned int size() const { return data.size(); }
+	/* true if something read past the end, or a wall index was bad */
+	bool failed() const { return overrun; }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef __SOFT_RENDERER_H__
+#define __SOFT_RENDERER_H__
+
+#include <vector>
+#include "SDL.h"
+#include "SDL_thread.h"
+#include "image.h"
+#include "renderer.h"
+
+/* draws on the CPU into an RGBA buffer in memory (top row first, 4 bytes
+	per pixel, alpha always 255), so frames can be made without a window
+	or a GL context.
+
+	draws are recorded, and done when the frame is finished; with more
+	than one band, the screen is split into bands of rows that are drawn
+	on their own threads, each going through all the draws in order.
+	textures are Images, given an id with setTexture (an Atlas that
+	wasn't uploaded has texture 0), and converted to RGBA there, so
+	unscaled sprites are copied a row at a time. texels are sampled
+	nearest, so sprites that are rotated or scaled can differ a little
+	from GL */
+class SoftRenderer : public Renderer
+{
+/* types */
+private:
+	struct Texture
+	{
+		GLuint id;
+		int w, h;
+		std::vector<Uint32> texels;
+
+		const Uint32 *row(int j) const { return &texels[j * w]; }
+	};
+
+	struct Command
+	{
+		Primitive type;
+		const Texture *texture;
+		int first, count;
+		bool blend;
+	};
+
+	struct Band
+	{
+		SoftRenderer *renderer;
+		int top, bottom;
+		SDL_Thread *thread;
+	};
+
+/* fields */
+private:
+	int width, height;
+	std::vector<Uint32> pixels;
+
+	std::vector<Texture> textures;
+	std::vector<Command> commands;
+	std::vector<SpriteVertex> vertices;
+	Uint32 clearColor;
+	bool cleared;
+
+	/* bands[0] is drawn on the calling thread */
+	std::vector<Band> bands;
+	SDL_mutex *lock;
+	SDL_cond *wake, *done;
+	int frame, bandsDone;
+	bool quit;
+
+/* constructors */
+public:
+	SoftRenderer(int _width, int _height, int numBands = 1);
+	~SoftRenderer();
+
+/* methods */
+private:
+	static int threadFunc(void *data);
+	void runBand(Band &band);
+	void drawBand(int top, int bottom);
+	void drawQuad(const Command &c, const SpriteVertex *v, int top, int bottom);
+	void drawLine(const Command &c, const SpriteVertex *v, int top, int bottom);
+	bool copyQuad(const Command &c, const SpriteVertex *v, int top, int bottom);
+	bool fillQuad(const Command &c, const SpriteVertex *v, int top, int bottom);
+
+	static Uint32 texelAt(const Texture *t, float u, float v);
+	/* blends color over n pixels, with alpha 0-255 */
+	static void blendRow(Uint32 *dest, Uint32 color, int alpha, int n);
+
+public:
+	/* the image is copied; set it again after it changes */
+	void setTexture(GLuint id, const Image &image);
+
+	void clear();
+	void draw(Primitive type, GLuint texture, const SpriteVertex *v, int n,
+		bool blend);
+	/* draws everything since clear() */
+	void finish();
+	void readPixels(Uint8 *rgba, int width, int height);
+
+/* getters */
+public:
+	const char *getName() const { return "software"; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	int getNumBands() const { return bands.size(); }
+	/* the finished frame */
+	const Uint32 * getPixels() const { return &pixels[0]; }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef __SPRITE_BATCH_H__
+#define __SPRITE_BATCH_H__
+
+#include <vector>
+#include "atlas.h"
+#include "color.h"
+#include "point.h"
+#include "renderer.h"
+
+class SpriteBatch
+{
+/* fields */
+private:
+	const Atlas &atlas;
+	Renderer *renderer;
+	std::vector<SpriteVertex> vertices;
+	std::vector<SpriteVertex> lines;
+
+public:
+	static const Color White;
+
+/* constructors */
+public:
+	SpriteBatch(const Atlas &_atlas) : atlas(_atlas), renderer(NULL) {}
+
+/* methods */
+private:
+	void addVertex(std::vector<SpriteVertex> &list, float x, float y,
+		float u, float v, const Color &c);
+
+public:
+	/* axis aligned quad, upper left at x,y */
+	void draw(const Sprite &s, float x, float y, float w, float h,
+		const Color &c = White);
+	/* arbitrary quad, corners in clockwise order starting with the upper
+		left of the sprite */
+	void draw(const Sprite &s, const Point corners[4], const Color &c = White);
+	/* untextured line; lines are drawn after the quads in the batch */
+	void line(const Point &p0, const Point &p1, const Color &c);
+	void flush();
+
+/* setters */
+public:
+	void setRenderer(Renderer *r) { renderer = r; }
+
+/* getters */
+public:
+	const Atlas & getAtlas() const { return atlas; }
+};
+
+#endif
@@ -4,6 +4,8 @@
 #include <list>
 #include "tilemapentry.h"
 
+class Arena;
+
 class TileMap
 {
 /* fields */
@@ -13,8 +15,9 @@ private:
 
 /* constructors */
 public:
-	TileMap(unsigned int _width, unsigned int _height);
-	~TileMap();
+	/* the entries (and their wall lists) are allocated from the arena,
+		and go away with it */
+	TileMap(unsigned int _width, unsigned int _height, Arena &arena);
 
 /* methods */
 public:
@@ -13,7 +13,7 @@ class TileMapEntry
 {
 /* types */
 public:
-	typedef std::list<TileMapEntry *> PList;
+	typedef Wall::TileList PList;
 	typedef PList::iterator PListIterator;
 	typedef PList::const_iterator PListConstIterator;
 
@@ -27,7 +27,8 @@ private:
 
 /* constructors */
 public:
-	TileMapEntry::TileMapEntry(Tile::TileType _type = Tile::EMPTY) : type(_type), region(NULL) {}
+	TileMapEntry(MemoryResource *resource = NULL):
+		region(NULL), type(Tile::EMPTY), walls(Wall::CPList::allocator_type(resource)) {}
 
 /* methods */
 public:
@@ -34,6 +34,50 @@ public:
 	Edge(const Edge &e): segment(e.segment), type(e.type) {}
 };
 
+/* a point on the half tile grid (4 pixels), where all of the tiles' corners
+	and midpoints are */
+struct GridPoint
+{
+	short x, y;
+
+	GridPoint() : x(0), y(0) {}
+	GridPoint(int _x, int _y) : x(_x), y(_y) {}
+};
+
+inline bool operator ==(const GridPoint &a, const GridPoint &b) { return a.x == b.x && a.y == b.y; }
+inline bool operator !=(const GridPoint &a, const GridPoint &b) { return !(a == b); }
+
+/* an Edge on the grid. Walls merges these, so collinear and equal mean
+	exactly that; the Segment (and its normal) is only made for the walls
+	that are left at the end */
+struct GridEdge
+{
+/* fields */
+public:
+	static const int SCALE = 4;		/* pixels per grid step */
+
+	GridPoint p0, p1;
+	Edge::EdgeType type;
+
+/* constructors */
+public:
+	GridEdge(const GridPoint &_p0, const GridPoint &_p1, Edge::EdgeType _type):
+		p0(_p0), p1(_p1), type(_type) {}
+
+/* methods */
+public:
+	/* the edge of a tile, moved to tile i,j */
+	GridEdge at(int i, int j) const;
+	Segment toSegment() const;
+	/* like Segment's. p0 isn't set for edges that cross (Walls doesn't
+		need it, and it usually isn't on the grid) */
+	Segment::IntersectType intersect(const GridEdge &t, GridPoint &p0, GridPoint &p1) const;
+	bool contains(const GridEdge &e) const;
+	bool sameDirection(const GridEdge &e) const;
+	/* whether they're on the same line, anywhere along it */
+	bool sameLine(const GridEdge &e) const;
+};
+
 struct Tile
 {
 /* types */
@@ -84,10 +128,12 @@ public:
 
 /* fields */
 public:
-	std::list<Edge> edges;
+	std::vector<GridEdge> edges;
 
 public:
 	static const unsigned int tileWidth, tileHeight;
+	/* in grid steps */
+	static const int GRID_SIZE = 2;
 
 /* constructors */
 	Tile() {}
@@ -95,13 +141,16 @@ public:
 
 /* methods */
 public:
-	void addEdge(const Edge &e) { edges.push_back(e); }
+	void addEdge(const GridEdge &e) { edges.push_back(e); }
 };
 
 class Tiles
 {
 /* fields */
 	std::vector<Tile> tiles;
+	/* the normal of each direction an edge can go, indexed by the
+		direction in grid steps (reduced, so each component is -2 to 2) */
+	Vector normals[5][5];
 
 /* singleton generator */
 public:
@@ -109,14 +158,17 @@ public:
 
 /* constructors */
 private:
-	Tiles() : tiles(28) { makeTiles(); }
+	Tiles() : tiles(28) { makeTiles(); makeNormals(); }
 
 /* methods */
 private:
 	void addTile(int tileIndex, const Tile &t) { tiles[tileIndex] = t; }
 	void makeTiles();
+	void makeNormals();
 public:
 	const Tile &getTile(int index) const { return tiles[index]; }
+	/* the normal of a segment going dx,dy grid steps */
+	const Vector &getNormal(int dx, int dy) const;
 };
 
 #endif
\ No newline at end of file
@@ -7,15 +7,16 @@
 
 /* forward declaration */
 struct Point;
+class SpriteBatch;
 
 struct Vector
 {
 /* fields */
-	float u, v;
+	real u, v;
 
 /* constructors */
 	Vector(): u(0), v(0) {}
-	Vector(float _u, float _v) : u(_u), v(_v) {}
+	Vector(real _u, real _v) : u(_u), v(_v) {}
 	Vector(const Point &a);
 	Vector(const Point &a, const Point &b);
 	Vector(const Vector &a) : u(a.u), v(a.v) {}
@@ -24,22 +25,22 @@ struct Vector
 	Vector & operator =(const Vector &a)  { u  = a.u; v  = a.v; return *this; }
 	Vector & operator +=(const Vector &a) { u += a.u; v += a.v; return *this; }
 	Vector & operator -=(const Vector &a) { u -= a.u; v -= a.v; return *this; }
-	Vector & operator *=(float b) { u *= b; v *= b; return *this; }
+	Vector & operator *=(real b) { u *= b; v *= b; return *this; }
 
-	static float dot(const Vector &a, const Vector &b) { return a.u * b.u + a.v * b.v; }
+	static real dot(const Vector &a, const Vector &b) { return a.u * b.u + a.v * b.v; }
 	static Vector perp(const Vector &a) { return Vector(a.v,-a.u); }
-	static float perp(const Vector &a, const Vector &b) { return a.u * b.v - a.v * b.u; }
+	static real perp(const Vector &a, const Vector &b) { return a.u * b.v - a.v * b.u; }
 
-	float length() const { return (float)sqrt(u*u+v*v); }
-	void normalize() { float l = length(); if (l != 0) { u /= l; v /= l; } }
+	real length() const { return (real)sqrt(u*u+v*v); }
+	void normalize() { real l = length(); if (l != 0) { u /= l; v /= l; } }
 
-	void draw(const Point &p);
+	void draw(SpriteBatch &batch, const Point &p);
 };
 
 inline Vector operator +(const Vector &a, const Vector &b) { Vector r = a; r += b; return r; }
 inline Vector operator -(const Vector &a, const Vector &b) { Vector r = a; r -= b; return r; }
-inline Vector operator *(const Vector &a, float b) { Vector r = a; r *= b; return r; }
-inline Vector operator *(float b, const Vector &a) { Vector r = a; r *= b; return r; }
+inline Vector operator *(const Vector &a, real b) { Vector r = a; r *= b; return r; }
+inline Vector operator *(real b, const Vector &a) { Vector r = a; r *= b; return r; }
 
 inline Vector operator +(const Vector &a) { return a; }
 inline Vector operator -(const Vector &a) { return Vector(-a.u, -a.v); }
@@ -3,6 +3,7 @@
 
 #include <list>
 #include <algorithm>
+#include "memory.h"
 #include "segment.h"
 #include "tiles.h"
 
@@ -12,23 +13,34 @@ struct Wall
 {
 /* types */
 public:
-	typedef std::list<Wall> List;
+	/* the lists take a MemoryResource: the Level's arena when they belong
+		to a map (see Level), the heap otherwise */
+	typedef std::list<Wall, Allocator<Wall> > List;
 	typedef List::iterator ListIterator;
 	typedef List::const_iterator ListConstIterator;
 
-	typedef std::list<const Wall *> CPList;
+	typedef std::list<const Wall *, Allocator<const Wall *> > CPList;
 	typedef CPList::iterator CPListIterator;
 	typedef CPList::const_iterator CPListConstIterator;
 
+	typedef std::list<TileMapEntry *, Allocator<TileMapEntry *> > TileList;
+
 /* fields */
 public:
 	Edge wall;
-	std::list<TileMapEntry *> tiles;
+	/* what the wall is built from; wall is made from it once the walls
+		are all merged */
+	GridEdge grid;
+	TileList tiles;
+	/* position in Walls, so a pointer to the wall can be saved */
+	int index;
 
 /* constructors */
 public:
-	Wall(const Edge &_wall) : wall(_wall) {}
-	Wall(const Wall &w): wall(w.wall), tiles(w.tiles) {}
+	Wall(const GridEdge &_grid, MemoryResource *resource = NULL):
+		wall(Segment(Point(), Point(), Vector()), _grid.type), grid(_grid),
+		tiles(TileList::allocator_type(resource)), index(-1) {}
+	Wall(const Wall &w): wall(w.wall), grid(w.grid), tiles(w.tiles), index(w.index) {}
 
 /* methods */
 public:
@@ -3,31 +3,119 @@
 
 #include <list>
 #include <set>
+#include <vector>
+#include "SDL.h"
+#include "SDL_thread.h"
+#include "segmentbatch.h"
 #include "wall.h"
+#include "walltree.h"
 
-class Background;
+class Arena;
+class Level;
+class SpriteBatch;
 class TileMap;
 class TileMapEntry;
 
 class Walls
 {
+/* types */
+private:
+	typedef std::vector<const Wall *, Allocator<const Wall *> > CPVector;
+	typedef std::vector<Wall::ListIterator, Allocator<Wall::ListIterator> > MadeVector;
+	typedef std::vector<int, Allocator<int> > KeyVector;
+
+	/* the walls are built in bands of rows, each on its own thread (the
+		first on the calling one). a band can't see the walls above it, so
+		the lines that cross its top are made again by stitch() once the
+		band above is done. the walls of every band end up in bands[0] */
+	struct Band
+	{
+		Walls *owner;
+		Level *level;
+		int top, bottom;
+		Wall::List walls;
+		/* the walls next to the edge being added (kept to reuse the
+			memory), and where each wall is in the list, by the order they
+			were made in */
+		CPVector nearby;
+		MadeVector made;
+		/* when each wall would have been made by a single band, also by
+			the order they were made in; see makeKey */
+		KeyVector keys;
+		int key;
+		Arena *fork;
+		SDL_Thread *thread;
+
+		Band(Walls *_owner, Level *_level, int _top, int _bottom, MemoryResource *resource):
+			owner(_owner), level(_level), top(_top), bottom(_bottom),
+			walls(Wall::List::allocator_type(resource)),
+			nearby(Allocator<const Wall *>(resource)),
+			made(Allocator<Wall::ListIterator>(resource)),
+			keys(Allocator<int>(resource)),
+			key(0), fork(NULL), thread(NULL) {}
+	};
+
+	typedef std::vector<Band, Allocator<Band> > BandVector;
+
+	struct MadeBefore
+	{
+		bool operator()(const Wall *a, const Wall *b) const { return a->index < b->index; }
+	};
+
+	struct KeyBefore
+	{
+		const KeyVector &keys;
+
+		KeyBefore(const KeyVector &_keys): keys(_keys) {}
+		bool operator()(const Wall *a, const Wall *b) const { return keys[a->index] < keys[b->index]; }
+		bool operator()(const Wall &a, const Wall &b) const { return keys[a.index] < keys[b.index]; }
+	};
+
 /* fields */
 private:
+	/* a band has at least this many rows */
+	static const int MIN_BAND_ROWS;
+	/* the most edges a tile has */
+	static const int MAX_EDGES;
+
+	Arena *arena;
+	int tileWidth;
 	Wall::List walls;
+	/* the walls again, by Wall::index */
+	std::vector<const Wall *, Allocator<const Wall *> > index;
+	/* and their segments, packed by Wall::index for collision */
+	SegmentBatch batch;
+	/* and in a tree, for queries that cover more than a few tiles */
+	WallTree tree;
 
 /* constructors */
 public:
-	Walls(Background &bg);
+	Walls(Level &level);
 
 /* methods */
 private:
-	void addWall(const Edge &e, TileMap &tilemap, TileMapEntry &tme);
-	void addTile(TileMap &tilemap, TileMapEntry &tme);
+	static int bandThread(void *data);
+	void buildBand(Band &b);
+	void addWall(Band &b, const GridEdge &e, TileMap &tilemap, TileMapEntry &tme);
+	Wall *addWall(Band &b, const GridEdge &e);
+	void addNearby(Band &b, const TileMapEntry *tme);
+	void addTile(Band &b, TileMap &tilemap, TileMapEntry &tme);
 	void remapWall(const Wall &w, Wall *new1, Wall *new2);
-	void removeWall(const Wall *w);
+	void removeWall(Band &b, const Wall *w);
+	int makeKey(const TileMapEntry &tme, int edge) const;
+	void merge(Band &all, Band &b);
+	bool stitch(Band &all, const Band &b, int first, TileMap &tilemap);
+	void buildIndex();
+
+public:
+	void draw(SpriteBatch &batch);
 
+/* getters */
 public:
-	void draw();
+	int size() const { return index.size(); }
+	const Wall * getWall(int i) const { return index[i]; }
+	const SegmentBatch & getBatch() const { return batch; }
+	const WallTree & getTree() const { return tree; }
 };
 
 #endif
\ No newline at end of file
@@ -6,12 +6,25 @@
 
 class TileMapEntry;
 
-class WallSet : public std::set<const Wall *>
+/* walls are visited in the order Walls numbered them, so collision doesn't
+	depend on where they were allocated */
+struct WallBefore
+{
+	bool operator()(const Wall *a, const Wall *b) const { return a->index < b->index; }
+};
+
+class WallSet : public std::set<const Wall *, WallBefore, Allocator<const Wall *> >
 {
 /* types */
 public:
-	typedef std::set<const Wall *>::iterator Iterator;
-	typedef std::set<const Wall *>::const_iterator ConstIterator;
+	typedef std::set<const Wall *, WallBefore, Allocator<const Wall *> > Base;
+	typedef Base::iterator Iterator;
+	typedef Base::const_iterator ConstIterator;
+
+/* constructors */
+public:
+	WallSet(MemoryResource *resource = NULL):
+		Base(WallBefore(), allocator_type(resource)) {}
 
 /* methods */
 public:
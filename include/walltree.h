@@ -0,0 +1,124 @@
+#ifndef __WALL_TREE_H__
+#define __WALL_TREE_H__
+
+#include <vector>
+#include "memory.h"
+#include "point.h"
+#include "vector.h"
+#include "circle.h"
+#include "wall.h"
+#include "wallset.h"
+
+/* bounding box tree over all the walls of a level, for queries that aren't
+	limited to a few tiles: raycasts, line of sight, sweeping a circle, and
+	finding the walls in an area. it's built once, when the level is
+	loaded, and never changes.
+
+	the nodes are in one array, depth first: a node's first child comes
+	right after it, and the second is at 'first' */
+class WallTree
+{
+/* types */
+public:
+	/* axis aligned box */
+	struct Box
+	{
+		real l, t, r, b;
+
+		Box() : l(0), t(0), r(0), b(0) {}
+		Box(real _l, real _t, real _r, real _b) : l(_l), t(_t), r(_r), b(_b) {}
+		Box(const Segment &s);
+		Box(const Circle &c);
+
+		void add(const Box &o);
+		bool overlaps(const Box &o) const
+		{
+			return l <= o.r && o.l <= r && t <= o.b && o.t <= b;
+		}
+	};
+
+	struct Hit
+	{
+		const Wall *wall;
+		/* fraction of the way from the start to the end */
+		real t;
+		/* raycast: where the ray hits the wall. sweep: where the center of
+			the circle is when it touches the wall */
+		Point point;
+	};
+
+	/* which walls a query sees: a mask of (1 << Edge::EdgeType) */
+	enum
+	{
+		ALL_TYPES = -1,
+		/* the ones you can't see through */
+		SIGHT_TYPES = 1 << Edge::SOLID
+	};
+
+private:
+	struct Node
+	{
+		Box box;
+		/* leaf: walls[first] to walls[first+count-1].
+			otherwise count is 0, and the second child is nodes[first] */
+		int first, count;
+	};
+
+	/* used while building */
+	struct Entry
+	{
+		const Wall *wall;
+		Box box;
+		real cx, cy;
+	};
+
+	struct CompareX
+	{
+		bool operator ()(const Entry &a, const Entry &b) const { return a.cx < b.cx; }
+	};
+
+	struct CompareY
+	{
+		bool operator ()(const Entry &a, const Entry &b) const { return a.cy < b.cy; }
+	};
+
+/* fields */
+private:
+	static const int LEAF_SIZE;
+	static const int MAX_DEPTH = 64;
+
+	std::vector<Node, Allocator<Node> > nodes;
+	std::vector<const Wall *, Allocator<const Wall *> > walls;
+
+/* constructors */
+public:
+	WallTree(MemoryResource *resource = NULL):
+		nodes(Allocator<Node>(resource)), walls(Allocator<const Wall *>(resource)) {}
+
+/* methods */
+private:
+	int build(std::vector<Entry> &entries, int begin, int end);
+	static bool accepts(const Wall &w, int types) { return (types >> w.wall.type) & 1; }
+
+public:
+	/* the walls are taken in order; see Walls::buildIndex */
+	void build(const std::vector<const Wall *, Allocator<const Wall *> > &index);
+
+	/* first wall crossed going from p to p+d */
+	bool raycast(const Point &p, const Vector &d, Hit &hit, int types = ALL_TYPES) const;
+	/* true if no wall is crossed between a and b; stops at the first one,
+		so it's cheaper than raycast */
+	bool lineOfSight(const Point &a, const Point &b, int types = SIGHT_TYPES) const;
+	/* first wall touched by a circle moving from c.center to c.center+d */
+	bool sweep(const Circle &c, const Vector &d, Hit &hit, int types = ALL_TYPES) const;
+	/* adds every wall that intersects the circle, or box */
+	void query(const Circle &c, WallSet &set, int types = ALL_TYPES) const;
+	void query(const Box &box, WallSet &set, int types = ALL_TYPES) const;
+
+/* getters */
+public:
+	bool empty() const { return nodes.empty(); }
+	int getNumNodes() const { return nodes.size(); }
+};
+
+#endif
\ No newline at end of file
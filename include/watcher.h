@@ -0,0 +1,50 @@
+#ifndef __WATCHER_H__
+#define __WATCHER_H__
+
+#include <string>
+#include <vector>
+#include <time.h>
+#include "SDL.h"
+
+/* notices when asset files change on disk. uses inotify where it exists,
+	otherwise checks modification times every POLL_INTERVAL ms */
+class AssetWatcher
+{
+/* types */
+private:
+	struct Asset
+	{
+		std::string file, name;
+		int id;
+		int watch;		/* inotify watch of the directory */
+		time_t mtime;
+	};
+
+/* consts */
+private:
+	static const Uint32 POLL_INTERVAL;
+
+/* fields */
+private:
+	std::vector<Asset> assets;
+	int notify;
+	Uint32 lastPoll;
+
+/* constructors */
+public:
+	AssetWatcher();
+	~AssetWatcher();
+
+/* methods */
+private:
+	static time_t modifiedTime(const char *file);
+	void readEvents(std::vector<int> &changed);
+	void checkTimes(std::vector<int> &changed);
+
+public:
+	void watch(const char *file, int id);
+	/* appends the id of every asset that changed since the last call */
+	void poll(std::vector<int> &changed);
+};
+
+#endif
\ No newline at end of file
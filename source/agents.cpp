@@ -0,0 +1,119 @@
+/***************************************************************************
+* SimFun
+*  agents.cpp -- many players sharing one world
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+#include <algorithm>
+#include "agents.h"
+#include "background.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "spritebatch.h"
+
+int Agents::add(const Player &proto, const Point &p)
+{
+	/* copy the prototype, so the agent gets its sprite */
+	agents.push_back(proto);
+
+	Player &a = agents.back();
+	a.setPos(p);
+	a.setOldPos(p);
+	a.clearIgnore();
+	a.setInput(0);
+
+	return agents.size() - 1;
+}
+
+void Agents::clearIgnore()
+{
+	std::vector<Player>::iterator i;
+	for (i = agents.begin(); i != agents.end(); ++i)
+		(*i).clearIgnore();
+}
+
+void Agents::update(Background &bg)
+{
+	/* basic idea:
+		* move everybody
+		* sort the agents by the tiles they touch, so agents standing in
+			the same place are next to each other
+		* gather the walls once for each run of agents with the same
+			tiles, and collide all of them against it
+		* settle everybody
+	*/
+	const TileMap &tilemap = bg.getTileMap();
+	WallSet walls(&Simulation::get().getFrameArena());
+	int n = agents.size();
+
+	for (int i = 0; i < n; i++)
+		agents[i].move();
+
+	queries.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		queries[i].bounds = agents[i].getTileBounds();
+		queries[i].agent = i;
+	}
+
+	std::sort(queries.begin(), queries.end());
+
+	for (int i = 0; i < n; )
+	{
+		const Object::TileBounds &tb = queries[i].bounds;
+
+		walls.clear();
+		Object::gatherWalls(tilemap, tb, walls);
+
+		for (; i < n && queries[i].bounds == tb; i++)
+			agents[queries[i].agent].doCollision(bg, walls);
+	}
+
+	for (int i = 0; i < n; i++)
+		agents[i].settle();
+}
+
+void Agents::draw(SpriteBatch &batch)
+{
+	std::vector<Player>::iterator i;
+	for (i = agents.begin(); i != agents.end(); ++i)
+		(*i).draw(batch);
+}
+
+void Agents::save(Snapshot &s) const
+{
+	s.put((int)agents.size());
+
+	std::vector<Player>::const_iterator i;
+	for (i = agents.begin(); i != agents.end(); ++i)
+		(*i).save(s);
+}
+
+void Agents::restore(Snapshot &s)
+{
+	int n;
+	s.get(n);
+
+	agents.resize(n);
+	std::vector<Player>::iterator i;
+	for (i = agents.begin(); i != agents.end(); ++i)
+		(*i).restore(s);
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+/***************************************************************************
+* SimFun
+*  alloctrack.cpp -- counts heap allocations per subsystem
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <stdlib.h>
+#include <new>
+#include "alloctrack.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define THREAD_LOCAL __declspec(thread)
+#define ATOMIC_ADD(var, n) InterlockedExchangeAdd((volatile LONG *)&(var), (LONG)(n))
+#else
+#define THREAD_LOCAL __thread
+#define ATOMIC_ADD(var, n) __sync_fetch_and_add(&(var), (n))
+#endif
+
+static const char *tagNames[AllocTracker::NUM_TAGS] =
+{
+	"other",
+	"player",
+	"agents",
+	"particles",
+	"render",
+	"loader"
+};
+
+/* the loader thread allocates at the same time as the main thread, so the
+	counters are updated atomically; the tag is per thread */
+static THREAD_LOCAL int currentTag = AllocTracker::OTHER;
+static volatile long counters[AllocTracker::NUM_TAGS][4];
+static volatile long liveBytes = 0;
+
+#ifdef SIMFUN_TRACK_ALLOCS
+
+#if __cplusplus >= 201103L
+#define THROWS_BAD_ALLOC
+#define NO_THROW noexcept
+#else
+#define THROWS_BAD_ALLOC throw(std::bad_alloc)
+#define NO_THROW throw()
+#endif
+
+/* every block starts with its size, so frees can be counted in bytes. 16
+	bytes keeps the memory after it aligned like malloc's */
+static const size_t HEADER_SIZE = 16;
+
+static void *trackedAlloc(size_t n)
+{
+	char *p = (char *)malloc(n + HEADER_SIZE);
+	if (p == NULL) return NULL;
+
+	*(size_t *)p = n;
+	ATOMIC_ADD(counters[currentTag][0], 1);
+	ATOMIC_ADD(counters[currentTag][2], (long)n);
+	ATOMIC_ADD(liveBytes, (long)n);
+	return p + HEADER_SIZE;
+}
+
+static void trackedFree(void *mem)
+{
+	if (mem == NULL) return;
+
+	char *p = (char *)mem - HEADER_SIZE;
+	size_t n = *(size_t *)p;
+	ATOMIC_ADD(counters[currentTag][1], 1);
+	ATOMIC_ADD(counters[currentTag][3], (long)n);
+	ATOMIC_ADD(liveBytes, -(long)n);
+	free(p);
+}
+
+void *operator new(size_t n) THROWS_BAD_ALLOC
+{
+	void *p = trackedAlloc(n ? n : 1);
+	if (p == NULL) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t n) THROWS_BAD_ALLOC
+{
+	void *p = trackedAlloc(n ? n : 1);
+	if (p == NULL) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t n, const std::nothrow_t &) NO_THROW
+{
+	return trackedAlloc(n ? n : 1);
+}
+
+void *operator new[](size_t n, const std::nothrow_t &) NO_THROW
+{
+	return trackedAlloc(n ? n : 1);
+}
+
+void operator delete(void *p) NO_THROW { trackedFree(p); }
+void operator delete[](void *p) NO_THROW { trackedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) NO_THROW { trackedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) NO_THROW { trackedFree(p); }
+
+bool AllocTracker::isEnabled()
+{
+	return true;
+}
+
+#else
+
+bool AllocTracker::isEnabled()
+{
+	return false;
+}
+
+#endif
+
+void AllocTracker::setTag(Tag tag)
+{
+	currentTag = tag;
+}
+
+AllocTracker::Tag AllocTracker::getTag()
+{
+	return (Tag)currentTag;
+}
+
+const char *AllocTracker::getTagName(Tag tag)
+{
+	return tagNames[tag];
+}
+
+void AllocTracker::getStats(Stats stats[NUM_TAGS])
+{
+	for (int i = 0; i < NUM_TAGS; i++)
+	{
+		stats[i].allocs = counters[i][0];
+		stats[i].frees = counters[i][1];
+		stats[i].bytesAllocated = counters[i][2];
+		stats[i].bytesFreed = counters[i][3];
+	}
+}
+
+long AllocTracker::getLiveBytes()
+{
+	return liveBytes;
+}
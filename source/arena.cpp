@@ -0,0 +1,210 @@
+/***************************************************************************
+* SimFun
+*  arena.cpp -- allocates from big blocks, frees all at once
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <string.h>
+#include "arena.h"
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+const size_t Arena::DEFAULT_BLOCK_SIZE = 64 * 1024;
+/* keep the first allocation in a block aligned for anything */
+const size_t Arena::HEADER_SIZE = (sizeof(Block) + 15) & ~15;
+
+/* the fork this thread is attached to */
+static THREAD_LOCAL Arena *attached = NULL;
+
+Arena::Arena(size_t _blockSize):
+	blocks(NULL), blockSize(_blockSize), totalUsed(0), totalSize(0),
+	numBlocks(0), parent(NULL)
+{
+	memset(freeLists, 0, sizeof(freeLists));
+}
+
+void Arena::newBlock(size_t minSize)
+{
+	size_t size = blockSize;
+	if (size < minSize) size = minSize;
+
+	/* operator new rather than malloc, so the blocks show up in
+		AllocTracker */
+	Block *b = (Block *)::operator new(HEADER_SIZE + size);
+
+	b->next = blocks;
+	b->size = size;
+	b->used = 0;
+	blocks = b;
+
+	totalSize += size;
+	numBlocks++;
+}
+
+void *Arena::allocate(size_t n, size_t align)
+{
+	if (attached && attached->parent == this)
+		return attached->allocate(n, align);
+
+	/* small sizes are rounded up the same way deallocate does, so any
+		of them can go on a free list later */
+	if (n <= MAX_FREE_SIZE)
+	{
+		n = (n + FREE_GRANULE - 1) & ~(FREE_GRANULE - 1);
+
+		/* a freed allocation of the same size is just as good; everything
+			on a free list is aligned to at least FREE_GRANULE */
+		void *&head = freeLists[n / FREE_GRANULE];
+		if (head && align <= FREE_GRANULE)
+		{
+			void *p = head;
+			head = *(void **)p;
+			return p;
+		}
+	}
+
+	/* align is always a power of 2 */
+	size_t start = 0;
+	if (blocks)
+		start = (blocks->used + align - 1) & ~(align - 1);
+
+	if (blocks == NULL || start + n > blocks->size)
+	{
+		/* the rest of the current block is wasted; with big blocks and
+			small allocations that's very little */
+		newBlock(n);
+		start = 0;
+	}
+
+	void *p = (char *)blocks + HEADER_SIZE + start;
+	totalUsed += start + n - blocks->used;
+	blocks->used = start + n;
+	return p;
+}
+
+void Arena::deallocate(void *p, size_t n)
+{
+	/* there's room for the link in the freed memory: sizes are rounded up
+		to FREE_GRANULE, which is at least the size of a pointer */
+	if (p == NULL || n == 0 || n > MAX_FREE_SIZE) return;
+
+	if (attached && attached->parent == this)
+	{
+		attached->deallocate(p, n);
+		return;
+	}
+
+	n = (n + FREE_GRANULE - 1) & ~(FREE_GRANULE - 1);
+	void *&head = freeLists[n / FREE_GRANULE];
+	*(void **)p = head;
+	head = p;
+}
+
+void Arena::reset()
+{
+	if (numBlocks > 1)
+	{
+		size_t size = totalSize;
+		release();
+		if (blockSize < size) blockSize = size;
+	}
+	else if (blocks)
+	{
+		blocks->used = 0;
+		totalUsed = 0;
+		memset(freeLists, 0, sizeof(freeLists));
+	}
+}
+
+void Arena::release()
+{
+	while (blocks)
+	{
+		Block *next = blocks->next;
+		::operator delete(blocks);
+		blocks = next;
+	}
+
+	totalUsed = totalSize = 0;
+	numBlocks = 0;
+	memset(freeLists, 0, sizeof(freeLists));
+}
+
+Arena *Arena::fork()
+{
+	/* forks only live until the threads using them are done, so they
+		keep to the default block size */
+	Arena *f = new Arena();
+	f->parent = this;
+	return f;
+}
+
+void Arena::join(Arena *f)
+{
+	/* the fork's blocks go after the current one, which still has room
+		to allocate from */
+	if (f->blocks)
+	{
+		Block *last = f->blocks;
+		while (last->next) last = last->next;
+
+		if (blocks)
+		{
+			last->next = blocks->next;
+			blocks->next = f->blocks;
+		}
+		else
+			blocks = f->blocks;
+	}
+
+	/* and its free lists are still good for anything this arena hands out */
+	for (int i = 0; i < NUM_FREE_LISTS; i++)
+	{
+		void *p = f->freeLists[i];
+		if (p == NULL) continue;
+
+		while (*(void **)p) p = *(void **)p;
+		*(void **)p = freeLists[i];
+		freeLists[i] = f->freeLists[i];
+	}
+
+	totalUsed += f->totalUsed;
+	totalSize += f->totalSize;
+	numBlocks += f->numBlocks;
+
+	f->blocks = NULL;
+	delete f;
+}
+
+void Arena::attach()
+{
+	attached = this;
+}
+
+void Arena::detach()
+{
+	attached = NULL;
+}
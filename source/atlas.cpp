@@ -0,0 +1,277 @@
+/***************************************************************************
+* SimFun
+*  atlas.cpp -- packs all images into one texture
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+#include <algorithm>
+#include <string.h>
+#include "SDL_opengl.h"
+#include "SDL.h"
+#include "atlas.h"
+#include "misc.h"
+
+const int Atlas::PADDING = 1;
+
+Atlas::Atlas():
+	texture(0)
+{
+	/* the white sprite is used for untextured quads (particles), so they
+		can be drawn without switching textures */
+	sources.push_back(Source("", 2, 2, PADDING, 0));
+	sources.back().image.create(2, 2);
+	sources.back().image.fill(0xff);
+	sources.back().numSprites = 1;
+	sprites.resize(1);
+	white = 0;
+}
+
+Atlas::~Atlas()
+{
+	if (texture) glDeleteTextures(1, &texture);
+}
+
+int Atlas::add(const char *file)
+{
+	sources.push_back(Source(file, 0, 0, PADDING, sprites.size()));
+
+	Source &src = sources.back();
+	if (!src.image.load(file))
+	{
+		sources.pop_back();
+		return -1;
+	}
+
+	src.cellW = src.image.w;
+	src.cellH = src.image.h;
+	src.numSprites = 1;
+	sprites.resize(sprites.size() + 1);
+
+	return src.firstSprite;
+}
+
+int Atlas::addGrid(const char *file, int cellW, int cellH)
+{
+	sources.push_back(Source(file, cellW, cellH, 0, sprites.size()));
+
+	Source &src = sources.back();
+	if (!src.image.load(file))
+	{
+		sources.pop_back();
+		return -1;
+	}
+
+	/* cells are numbered left to right, top to bottom */
+	src.grid = true;
+	src.numSprites = (src.image.w / cellW) * (src.image.h / cellH);
+	sprites.resize(sprites.size() + src.numSprites);
+
+	return src.firstSprite;
+}
+
+bool Atlas::pack(std::vector<Cell> &cells, int width, int &height)
+{
+	/* simple shelf packing: cells are sorted tallest first, and placed left
+		to right; when a row is full, start a new one below the tallest cell
+		of the row */
+	int x = 0, y = 0, shelf = 0;
+
+	std::vector<Cell>::iterator i;
+	for (i = cells.begin(); i != cells.end(); ++i)
+	{
+		Cell &c = *i;
+		int w = c.w + 2*c.padding, h = c.h + 2*c.padding;
+
+		if (w > width) return false;
+		if (x + w > width)
+		{
+			y += shelf;
+			x = 0;
+			shelf = 0;
+		}
+
+		c.atlasX = x;
+		c.atlasY = y;
+		x += w;
+		shelf = std::max(shelf, h);
+	}
+
+	height = y + shelf;
+	return true;
+}
+
+void Atlas::copyCell(const Cell &c)
+{
+	/* source and atlas are both RGB, so this is just a copy per row */
+	for (int j = 0; j < c.h; j++)
+	{
+		const Uint8 *src = c.image->row(c.y + j) + c.x * 3;
+		Uint8 *dest = image.row(c.atlasY + c.padding + j) + (c.atlasX + c.padding) * 3;
+		memcpy(dest, src, c.w * 3);
+	}
+}
+
+void Atlas::extrudeCell(const Cell &c)
+{
+	/* copy the outermost texels of the cell into the padding around it */
+	if (c.padding == 0) return;
+
+	int pitch = image.w * 3;
+	Uint8 *first = image.row(c.atlasY + PADDING) + c.atlasX * 3;
+	Uint8 *last = first + (c.h - 1) * pitch;
+
+	for (int j = 0; j < c.h; j++)
+	{
+		Uint8 *row = first + j * pitch;
+		memcpy(row, row + 3, 3);
+		memcpy(row + (c.w + PADDING) * 3, row + c.w * 3, 3);
+	}
+
+	memcpy(first - pitch, first, (c.w + 2*PADDING) * 3);
+	memcpy(last + pitch, last, (c.w + 2*PADDING) * 3);
+}
+
+bool Atlas::build(bool uploadTexture)
+{
+	std::vector<Cell> cells;
+
+	/* split all the sources into cells */
+	std::vector<Source>::iterator s;
+	for (s = sources.begin(); s != sources.end(); ++s)
+	{
+		Source &src = *s;
+		int across = src.image.w / src.cellW;
+
+		for (int n = 0; n < src.numSprites; n++)
+		{
+			Cell c;
+			c.image = &src.image;
+			c.x = (n % across) * src.cellW;
+			c.y = (n / across) * src.cellH;
+			c.w = src.cellW;
+			c.h = src.cellH;
+			c.padding = src.padding;
+			c.sprite = src.firstSprite + n;
+			cells.push_back(c);
+		}
+	}
+
+	std::stable_sort(cells.begin(), cells.end(), TallerThan());
+
+	/* find the power of 2 texture with the smallest area that fits
+		everything */
+	int bestW = 0, bestH = 0;
+	for (int w = 16; w <= 2048; w <<= 1)
+	{
+		int used, h;
+		if (!pack(cells, w, used)) continue;
+
+		for (h = 1; h < used; h <<= 1);
+		if (bestW == 0 || w * h < bestW * bestH)
+		{
+			bestW = w;
+			bestH = h;
+		}
+	}
+
+	if (bestW == 0)
+	{
+		ErrorBox("Unable to fit images into atlas.\n");
+		return false;
+	}
+
+	int used;
+	pack(cells, bestW, used);
+
+	if (!image.create(bestW, bestH)) return false;
+	image.fill(0);
+
+	std::vector<Cell>::const_iterator i;
+	for (i = cells.begin(); i != cells.end(); ++i)
+		copyCell(*i);
+
+	for (i = cells.begin(); i != cells.end(); ++i)
+	{
+		const Cell &c = *i;
+		Sprite &sp = sprites[c.sprite];
+
+		extrudeCell(c);
+
+		sp.w = c.w;
+		sp.h = c.h;
+		sp.u0 = (c.atlasX + c.padding) / (float)bestW;
+		sp.v0 = (c.atlasY + c.padding) / (float)bestH;
+		sp.u1 = (c.atlasX + c.padding + c.w) / (float)bestW;
+		sp.v1 = (c.atlasY + c.padding + c.h) / (float)bestH;
+	}
+
+	if (uploadTexture) upload();
+	return true;
+}
+
+bool Atlas::reload()
+{
+	/* load everything first, so a bad file leaves the atlas untouched */
+	std::vector<Image> images(sources.size());
+
+	for (unsigned int i = 0; i < sources.size(); i++)
+	{
+		const Source &src = sources[i];
+		if (src.file.empty()) continue;
+
+		Image &img = images[i];
+		if (!img.load(src.file.c_str())) return false;
+
+		/* sprite indices are handed out when an image is added, so the
+			number of cells in a grid can't change */
+		if (src.grid && (img.w / src.cellW) * (img.h / src.cellH) != src.numSprites)
+		{
+			ErrorBox("Can't reload %s: number of cells changed\n", src.file.c_str());
+			return false;
+		}
+	}
+
+	for (unsigned int i = 0; i < sources.size(); i++)
+	{
+		Source &src = sources[i];
+		if (src.file.empty()) continue;
+
+		src.image = images[i];
+		if (!src.grid)
+		{
+			src.cellW = src.image.w;
+			src.cellH = src.image.h;
+		}
+	}
+
+	return build();
+}
+
+void Atlas::upload()
+{
+	if (texture == 0) glGenTextures(1, &texture);
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.w, image.h, 0, GL_RGB, GL_UNSIGNED_BYTE, image.pixels);
+}
@@ -1,6 +1,6 @@
 /***************************************************************************
 * SimFun
-*  background.cpp -- handles loading maps and drawing tiles
+*  background.cpp -- holds the current level and draws its tiles
 * Copyright (C) 2004	Ben Smith
 * 
 * This program is free software; you can redistribute it and/or
@@ -22,214 +22,238 @@
 *
 *****************************************************************************/
 
+#include <algorithm>
+#include <float.h>
 #include <math.h>
 #include "SDL_opengl.h"
 #include "SDL.h"
+#include "atlas.h"
 #include "background.h"
 #include "misc.h"
 #include "player.h"
+#include "spritebatch.h"
 #include "walls.h"
 
-void Background::drawTiles()
+void Background::drawTiles(SpriteBatch &batch)
 {
-	if (!map) return;
+	if (!level) return;
 
-	glEnable(GL_TEXTURE_2D);
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-
-	glPushMatrix();
-	glLoadIdentity();
-	glBindTexture(GL_TEXTURE_2D, tiles);
-
-	glBegin(GL_QUADS);
+	const Atlas &atlas = batch.getAtlas();
 
 	for (int j = 0; j < tileHeight; j++)
 	{
 		for (int i= 0; i < tileWidth; i++)
 		{
-			float t = mapIndex(i,j)*8/(float)image->h, b = t+8/(float)image->h;
-			
-			glTexCoord2f(0, t); 	glVertex2i(i*8+0,j*8+0);
-			glTexCoord2f(0, b); 	glVertex2i(i*8+0,j*8+8);
-			glTexCoord2f(1, b); 	glVertex2i(i*8+8,j*8+8);
-			glTexCoord2f(1, t); 	glVertex2i(i*8+8,j*8+0);				
+			/* tiles.bmp is a column of 8x8 tiles, one per tile type */
+			const Sprite &s = atlas.getSprite(tiles + mapIndex(i,j));
+			batch.draw(s, (float)i*8, (float)j*8, 8, 8);
 		}
 	}
+}
 
-	glEnd();
-
-	glPopMatrix();
-	glDisable(GL_TEXTURE_2D);
+void Background::drawWalls(SpriteBatch &batch)
+{
+	if (!level) return;
+	level->getWalls().draw(batch);
 }
 
-void Background::drawWalls()
+/* the part of p + t*d inside 0..hi, for one axis */
+static bool clipAxis(float p, float d, float hi, float &t0, float &t1)
 {
-	walls->draw();
+	if (d == 0) return p >= 0 && p <= hi;
+
+	float a = -p / d, b = (hi - p) / d;
+	if (a > b) std::swap(a, b);
+	t0 = std::max(t0, a);
+	t1 = std::min(t1, b);
+	return t0 <= t1;
 }
 
-void Background::readMapFromFile(const char *file)
+/* state of one raycast, while it goes from tile to tile */
+class RayWalk
 {
-	FILE *f;
-	
-	if ((f = fopen(file,"rb")) == NULL)
+/* fields */
+private:
+	/* walls cover several tiles, so the same one comes up again and again
+		along a ray; the last few tested are remembered so each is
+		intersected once */
+	static const int RECENT_WALLS = 8;
+
+	const Point &origin;
+	Vector d;
+	Segment ray;
+	int types;
+
+	const Wall *recent[RECENT_WALLS];
+	int numRecent, nextRecent;
+
+public:
+	Background::RayHit &hit;
+
+/* constructors */
+public:
+	RayWalk(const Point &_origin, const Vector &_d, float maxDist, int _types,
+		Background::RayHit &_hit):
+		origin(_origin), d(_d), ray(_origin, _origin + _d * maxDist), types(_types),
+		numRecent(0), nextRecent(0), hit(_hit)
 	{
-		ErrorBox("Can't open map: \"%s\"",file);
-		exit(1);
+		hit.wall = NULL;
+		hit.dist = maxDist;
 	}
 
-	map = new Tile::TileType [tileWidth * tileHeight];
+/* methods */
+public:
+	void testTile(const TileMapEntry *tme);
+};
+
+void RayWalk::testTile(const TileMapEntry *tme)
+{
+	if (tme == NULL) return;
 
-	int i = 0;
-	int c;
+	const Wall::CPList &walls = tme->getWalls();
+	Wall::CPListConstIterator w;
 
-	while (!feof(f) && i < tileWidth * tileHeight)
+	for (w = walls.begin(); w != walls.end(); ++w)
 	{
-		c = tolower(fgetc(f));
-
-		if (isalpha(c) && c - 'a' + 10 < Tile::MAX_TILE_TYPES)
-			map[i++] = (Tile::TileType)(c - 'a' + 10);
-		else if (isdigit(c) && c - '0' < Tile::MAX_TILE_TYPES)
-			map[i++] = (Tile::TileType)(c - '0');
-		else if (c == '\n' || c == '\r')
-			;
-		else
+		const Wall *wall = *w;
+		if (!((types >> wall->wall.type) & 1)) continue;
+		if (std::find(recent, recent + numRecent, wall) != recent + numRecent) continue;
+
+		recent[nextRecent] = wall;
+		nextRecent = (nextRecent + 1) % RECENT_WALLS;
+		numRecent = std::min(numRecent + 1, (int)RECENT_WALLS);
+
+		Point p0, p1;
+		Segment::IntersectType it = ray.intersect(wall->wall.segment, p0, p1);
+		if (it == Segment::DISJOINT) continue;
+
+		/* running along a wall hits it at the nearer end of the overlap */
+		float dist = Vector::dot(Vector(origin, p0), d);
+		if (it == Segment::SEGMENT && Vector::dot(Vector(origin, p1), d) < dist)
 		{
-			ErrorBox("Error reading map: \"%s\"",file);
-			fclose(f);
-			exit(1);
+			p0 = p1;
+			dist = Vector::dot(Vector(origin, p0), d);
 		}
-	}
-	
-	fclose(f);
-}
 
-void Background::loadMap(const char *file)
-{
-	deleteMap();
-	readMapFromFile(file);
-	tilemap = new TileMap(tileWidth, tileHeight);
-	walls = new Walls(*this);
-	mapRegions();
+		if (hit.wall == NULL || dist < hit.dist)
+		{
+			hit.wall = wall;
+			hit.point = p0;
+			hit.dist = dist;
+		}
+	}
 }
 
-void Background::deleteMap()
+bool Background::raycast(const Point &origin, const Vector &dir, float maxDist,
+	RayHit &hit, int types) const
 {
-	if (map) { delete [] map; map = NULL; }
-	if (walls) { delete walls; walls = NULL; }
-	if (tilemap) { delete tilemap; tilemap = NULL; }
-	regions.clear();
-}
+	hit.wall = NULL;
 
-void Background::loadTiles(const char *file)
-{
-	if ((image = loadBMP(file)) == NULL) exit(1);
-	if ((image = makeTexture(image)) == NULL) exit(1);
-
-	glGenTextures(1,&tiles);
-	glBindTexture(GL_TEXTURE_2D, tiles);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image->w, image->h, 0, GL_RGB, GL_UNSIGNED_BYTE, image->pixels);
-}
+	float len = dir.length();
+	if (!level || len == 0 || maxDist <= 0) return false;
 
-Background::~Background()
-{
-	deleteMap();
-	if (image) SDL_FreeSurface(image);
-}
+	Vector d = dir * (1 / len);
+	float size = (float)Tile::tileWidth;
 
-void Background::clearMappedTile()
-{
-	for (int i= 0; i< tileWidth * tileHeight; i++)
-		mappedTile[i] = false;
-}
+	/* start where the ray enters the map */
+	float t0 = 0, t1 = maxDist;
+	if (!clipAxis(origin.x, d.u, tileWidth * size, t0, t1) ||
+		!clipAxis(origin.y, d.v, tileHeight * size, t0, t1))
+		return false;
 
-void Background::paintIndex(Region &region, int i, int j)
-{
-	TileMapEntry *tme = tilemap->index(i,j);
-	if (tme == NULL) return;
+	Point start = origin + d * t0;
+	int i = std::min(std::max((int)floor(start.x / size), 0), tileWidth - 1);
+	int j = std::min(std::max((int)floor(start.y / size), 0), tileHeight - 1);
 
-	mappedTile[i + j*tileWidth] = true;
-	region.addFromTile(tme);
-	tme->setRegion(&region);
-}
+	/* distance from the origin to the next vertical and horizontal tile
+		edge, and between them */
+	int stepI = d.u > 0 ? 1 : -1, stepJ = d.v > 0 ? 1 : -1;
+	float nextX = FLT_MAX, nextY = FLT_MAX, deltaX = FLT_MAX, deltaY = FLT_MAX;
+	if (d.u != 0)
+	{
+		nextX = ((i + (d.u > 0)) * size - origin.x) / d.u;
+		deltaX = size / (float)fabs(d.u);
+	}
+	if (d.v != 0)
+	{
+		nextY = ((j + (d.v > 0)) * size - origin.y) / d.v;
+		deltaY = size / (float)fabs(d.v);
+	}
 
-bool Background::checkIndex(int i, int j, Tile::TileType type)
-{
-	return mapIndex(i, j) == type && !mappedTile[i + j*tileWidth];
-}
+	/* a tile's walls are on its edges, and each belongs to only one of
+		the tiles next to it. so a ray that starts on a tile edge, or runs
+		along one, can hit walls of tiles it never goes through */
+	bool leftEdge = start.x == i * size, topEdge = start.y == j * size;
+	bool alongX = d.v == 0 && topEdge, alongY = d.u == 0 && leftEdge;
 
-/* Paul Heckbert's Seed Fill algorithm/code */
-/********************************************************/
-/*
- * A Seed Fill Algorithm
- * by Paul Heckbert
- * from "Graphics Gems", Academic Press, 1990
- ...
- * Paul Heckbert	13 Sept 1982, 28 Jan 1987
- */
-/********************************************************/
-
-void Background::regionFill(Region &region, int i, int j)
-{
-	Tile::TileType type = region.getType();
-	std::stack<Strip> stack;
+	const TileMap &tilemap = getTileMap();
+	RayWalk walk(origin, d, maxDist, types, hit);
 
-	stack.push(Strip(i,i,j,1));
-	stack.push(Strip(i,i,j+1,-1));
+	if (leftEdge) walk.testTile(tilemap.index(i - 1, j));
+	if (topEdge) walk.testTile(tilemap.index(i, j - 1));
+	if (leftEdge && topEdge) walk.testTile(tilemap.index(i - 1, j - 1));
 
-	while (!stack.empty())
+	for (;;)
 	{
-		int x, l;
-		Strip s = stack.top(); stack.pop();
-		s.y += s.dy;
-		if (s.y < 0 || s.y >= tileHeight) continue;
-
-		for (x = s.xl; x >= 0 && checkIndex(x, s.y, type); --x)
-			paintIndex(region, x, s.y);
-
-		if (x >= s.xl) goto skip;
-		l = x + 1;
-		if (l < s.xl) stack.push(Strip(l, s.xl-1, s.y, -s.dy));
-		x = s.xl + 1;
-		do
-		{
-			for (; x < tileWidth && checkIndex(x, s.y, type); ++x)
-				paintIndex(region, x, s.y);
+		walk.testTile(tilemap.index(i, j));
+		if (alongX) walk.testTile(tilemap.index(i, j - 1));
+		if (alongY) walk.testTile(tilemap.index(i - 1, j));
 
-			stack.push(Strip(l, x-1, s.y, s.dy));
-			if (x > s.xr+1) stack.push(Strip(s.xr + 1, x - 1, s.y, -s.dy));
+		/* anything hit in a later tile is farther away than this */
+		float exit = std::min(nextX, nextY);
+		if ((hit.wall && hit.dist <= exit) || exit > t1) break;
 
-skip:		for (x++; x <= s.xr && mapIndex(x, s.y) != type; ++x);
-			l = x;
+		if (nextX < nextY)
+		{
+			i += stepI;
+			nextX += deltaX;
 		}
-		while (x <= s.xr);
+		else
+		{
+			j += stepJ;
+			nextY += deltaY;
+		}
+
+		if (i < 0 || i >= tileWidth || j < 0 || j >= tileHeight) break;
 	}
+
+	if (hit.wall == NULL) return false;
+
+	hit.normal = hit.wall->wall.segment.normal;
+	if (Vector::dot(hit.normal, d) > 0)
+		hit.normal = -hit.normal;
+
+	return true;
 }
 
-void Background::mapRegions()
+int Background::raycast(const Ray *rays, int n, RayHit *hits, int types) const
 {
-	mappedTile = new bool [tileWidth * tileHeight];
-	clearMappedTile();
-
-	/* basic idea:
-		* iterate over all tiles
-		* find ladder or water tile
-		* use fill algorithm (above) to map tiles to region
-		* add walls from tile to region
-		* profit
-	*/
-
-	for (int j= 0; j< tileHeight; j++)
-		for (int i= 0; i < tileWidth; i++)
-		{
-			Tile::TileType type = mapIndex(i,j);
-			if (mappedTile[i + j*tileWidth]) continue;
-			if (type != Tile::WATER && type != Tile::LADDER) continue;
+	int count = 0;
 
-			regions.push_back(Region(type));
-			regionFill(regions.back(), i,j);
-		}
+	for (int i = 0; i < n; i++)
+		if (raycast(rays[i].origin, rays[i].dir, rays[i].maxDist, hits[i], types))
+			count++;
+
+	return count;
+}
 
-	delete mappedTile;
+void Background::setLevel(Level *l)
+{
+	deleteMap();
+	level = l;
+}
+
+void Background::deleteMap()
+{
+	if (level) { delete level; level = NULL; }
+}
+
+void Background::loadTiles(Atlas &atlas, const char *file)
+{
+	if ((tiles = atlas.addGrid(file, Tile::tileWidth, Tile::tileHeight)) < 0) exit(1);
+}
+
+Background::~Background()
+{
+	deleteMap();
 }
\ No newline at end of file
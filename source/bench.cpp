@@ -0,0 +1,284 @@
+/***************************************************************************
+* SimFun
+*  bench.cpp -- runs the simulation without graphics, as fast as it can
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "alloctrack.h"
+#include "botinput.h"
+#include "level.h"
+#include "simulation.h"
+#include "softrenderer.h"
+#include "misc.h"
+
+/* the script played on every map: run, jump, dive, climb, both ways. the
+	maps all have water and ladders within reach of the start, so this
+	gets splashes (and their drops) going */
+static const ScriptInput::Step script[] =
+{
+	{ 90, Player::RIGHT, false },
+	{ 90, Player::RIGHT | Player::JUMP, true },
+	{ 60, Player::DOWN, false },
+	{ 30, Player::UP | Player::JUMP, true },
+	{ 90, Player::LEFT, false },
+	{ 90, Player::LEFT | Player::JUMP, true },
+	{ 60, Player::UP, false },
+	{ 60, Player::DOWN | Player::RIGHT, false },
+};
+
+static const int scriptSteps = sizeof(script) / sizeof(script[0]);
+
+static const int numPhases = Simulation::PhaseTimes::NUM_PHASES;
+
+struct Result
+{
+	double phase[numPhases], render, capture;
+	int peakParticles;
+
+	/* only counted after the warm up */
+	long allocs[numPhases], bytes[numPhases];
+	long frees[numPhases], bytesFreed[numPhases];
+	int allocTicks;
+};
+
+static void runMap(int map, int ticks, int warmup, int numAgents,
+	InputSource &input, Renderer *renderer, FrameCapture *capture, Result &r)
+{
+	Simulation &sim = Simulation::get();
+	Player &player = sim.getPlayer();
+	Agents &agents = sim.getAgents();
+	Particles &particles = sim.getParticles();
+
+	/* same random numbers every run */
+	setRandomState(1);
+	sim.loadMapNow(map);
+
+	for (int i = 0; i < numAgents; i++)
+		agents.add(player, player.getPos() + Vector((float)(i % 8) * 4 - 16, 0));
+
+	memset(&r, 0, sizeof(r));
+
+	for (int t = 0; t < ticks; t++)
+	{
+		int buttons = input.nextButtons();
+		Simulation::PhaseTimes times;
+		sim.step(&buttons, 1, &times);
+
+		/* not part of the tick, so timed separately */
+		double t0 = getTime(), t1 = t0, t2 = t0;
+		if (renderer)
+		{
+			sim.render();
+			t1 = t2 = getTime();
+		}
+
+		/* every frame is kept, so this waits when the writer falls behind */
+		if (capture)
+		{
+			renderer->readPixels(capture->beginFrame(true), 640, 480);
+			capture->endFrame();
+			t2 = getTime();
+		}
+
+		for (int p = 0; p < numPhases; p++)
+			r.phase[p] += times.time[p];
+		r.render += t1 - t0;
+		r.capture += t2 - t1;
+
+		int n = particles.size();
+		if (n > r.peakParticles) r.peakParticles = n;
+
+		if (t < warmup) continue;
+
+		bool allocated = false;
+		for (int p = 0; p < numPhases; p++)
+		{
+			const AllocTracker::Stats &s = times.allocs[p];
+			r.allocs[p] += s.allocs;
+			r.bytes[p] += s.bytesAllocated;
+			r.frees[p] += s.frees;
+			r.bytesFreed[p] += s.bytesFreed;
+			if (s.allocs) allocated = true;
+		}
+		if (allocated) r.allocTicks++;
+	}
+}
+
+static void usage()
+{
+	printf(
+		"usage: bench [-t ticks] [-a agents] [-min ticks_per_sec] [-w warmup] [-noalloc]\n"
+		"             [-render bands [-capture file]] [-bot] [-loadthreads n]\n"
+		"  -t        ticks to run on each map (default 20000)\n"
+		"  -a        extra players copying the script (default 0)\n"
+		"  -min      fail (exit code 1) if any map runs slower than this\n"
+		"  -w        ticks before allocations are counted (default 2000)\n"
+		"  -noalloc  fail (exit code 1) if a tick allocates after the warm up;\n"
+		"            needs a build with SIMFUN_TRACK_ALLOCS\n"
+		"  -render   draw every tick in software, split in bands of rows drawn\n"
+		"            on that many threads; not counted in ticks/sec\n"
+		"  -capture  write every frame drawn with -render to file (.raw, .ppm,\n"
+		"            .png or .y4m)\n"
+		"  -bot      the player is steered around each map by a bot, instead\n"
+		"            of following the script\n"
+		"  -loadthreads  threads each map is loaded on (default 4)\n");
+}
+
+int main(int argc, char **argv)
+{
+	int ticks = 20000, numAgents = 0, warmup = 2000, renderBands = 0;
+	const char *captureFile = NULL;
+	double minRate = 0;
+	bool noAlloc = false, useBot = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			ticks = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+			numAgents = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-min") == 0 && i + 1 < argc)
+			minRate = atof(argv[++i]);
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+			warmup = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-noalloc") == 0)
+			noAlloc = true;
+		else if (strcmp(argv[i], "-render") == 0 && i + 1 < argc)
+			renderBands = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-capture") == 0 && i + 1 < argc)
+			captureFile = argv[++i];
+		else if (strcmp(argv[i], "-bot") == 0)
+			useBot = true;
+		else if (strcmp(argv[i], "-loadthreads") == 0 && i + 1 < argc)
+			Level::setThreads(atoi(argv[++i]));
+		else
+		{
+			usage();
+			return 2;
+		}
+	}
+
+	if (ticks <= 0 || (captureFile && renderBands <= 0))
+	{
+		usage();
+		return 2;
+	}
+
+	if (noAlloc && !AllocTracker::isEnabled())
+	{
+		printf("-noalloc needs a build with SIMFUN_TRACK_ALLOCS defined\n");
+		return 2;
+	}
+
+	/* no window, so the atlas stays in memory for the SoftRenderer */
+	SoftRenderer *soft = NULL;
+	if (renderBands > 0)
+	{
+		Simulation &sim = Simulation::get();
+		sim.loadImages(false);
+
+		soft = new SoftRenderer(640, 480, renderBands);
+		soft->setTexture(sim.getAtlas().getTexture(), sim.getAtlas().getImage());
+		sim.setRenderer(soft);
+	}
+
+	FrameCapture capture;
+	if (captureFile && !capture.start(captureFile, 640, 480, 60))
+		return 2;
+
+	Simulation &sim = Simulation::get();
+	ScriptInput scripted(script, scriptSteps);
+	BotInput bot(sim.getPlayer(), sim.getBackground());
+	InputSource &input = useBot ? (InputSource &)bot : scripted;
+
+	bool failed = false;
+
+	printf("%-20s %10s %10s %10s %10s %10s %10s\n", "map", "ticks/sec",
+		"player", "agents", "particles", "peak", "memory");
+	printf("%-20s %10s %10s %10s %10s %10s %10s\n", "", "",
+		"(us/tick)", "(us/tick)", "(us/tick)", "particles", "(KB)");
+
+	for (int map = 0; map < Simulation::getNumMaps(); map++)
+	{
+		Result r;
+		scripted.rewind();
+		runMap(map, ticks, warmup, numAgents, input, soft,
+			capture.isRunning() ? &capture : NULL, r);
+
+		double total = 0;
+		for (int p = 0; p < numPhases; p++)
+			total += r.phase[p];
+		double rate = total > 0 ? ticks / total : 0;
+
+		printf("%-20s %10.0f", Simulation::getMapName(map), rate);
+		for (int p = 0; p < numPhases; p++)
+			printf(" %10.2f", r.phase[p] * 1e6 / ticks);
+		printf(" %10d %10ld\n", r.peakParticles, getPeakMemory() / 1024);
+
+		if (soft)
+			printf("  render: %.2f us/tick (%d bands)\n", r.render * 1e6 / ticks,
+				soft->getNumBands());
+		if (capture.isRunning())
+			printf("  capture: %.2f us/tick\n", r.capture * 1e6 / ticks);
+
+		if (minRate > 0 && rate < minRate)
+		{
+			printf("  FAILED: below %.0f ticks/sec\n", minRate);
+			failed = true;
+		}
+
+		if (AllocTracker::isEnabled() && ticks > warmup)
+		{
+			int counted = ticks - warmup;
+
+			printf("  per tick after %d ticks:\n", warmup);
+			for (int p = 0; p < numPhases; p++)
+				printf("    %-10s %.2f allocs (%.0f bytes), %.2f frees (%.0f bytes)\n",
+					AllocTracker::getTagName(Simulation::PhaseTimes::getTag(p)),
+					(double)r.allocs[p] / counted, (double)r.bytes[p] / counted,
+					(double)r.frees[p] / counted, (double)r.bytesFreed[p] / counted);
+			printf("  ticks that allocated: %d of %d\n", r.allocTicks, counted);
+
+			if (noAlloc && r.allocTicks > 0)
+			{
+				printf("  FAILED: steady state ticks allocate\n");
+				failed = true;
+			}
+		}
+	}
+
+	/* let the writer catch up before reporting */
+	if (capture.isRunning())
+	{
+		double t = getTime();
+		capture.stop();
+		printf("capture: %d frames, %.2f s to finish writing\n",
+			capture.getCaptured(), getTime() - t);
+		if (!capture.isOK()) failed = true;
+	}
+
+	delete soft;
+	return failed ? 1 : 0;
+}
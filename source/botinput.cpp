@@ -0,0 +1,236 @@
+/***************************************************************************
+* SimFun
+*  botinput.cpp -- steers a player along NavGraph paths
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <algorithm>
+#include <math.h>
+#include "background.h"
+#include "botinput.h"
+#include "player.h"
+#include "walls.h"
+
+const int BotInput::REPLAN_TICKS = 60;
+const int BotInput::STUCK_TICKS = 300;
+
+/* in pixels: how close counts as being at a waypoint (standing places
+	are a bit looser up and down, for slopes), and how far off it has to
+	be before the bot moves toward it */
+static const real REACH = 6;
+static const real REACH_STAND = 20;
+static const real DEAD_ZONE = 3;
+/* the slowing down the bot counts on, in pixels per tick per tick; a bit
+	less than the player's, so it stops in time */
+static const real BRAKE = 0.08f;
+static const real MAX_SPEED = 3;
+
+BotInput::BotInput(Player &_player, const Background &_bg):
+	player(_player), bg(_bg), level(NULL),
+	hasGoal(false), wander(true), next(0),
+	sinceReplan(0), sinceProgress(0), lastButtons(0), randomState(1)
+{
+}
+
+Uint32 BotInput::random()
+{
+	/* the same LCG as frand */
+	randomState = randomState * 1664525 + 1013904223;
+	return randomState >> 8;
+}
+
+void BotInput::setGoal(const Point &p)
+{
+	goal = p;
+	hasGoal = true;
+	wander = false;
+	sinceProgress = 0;
+	path.clear();
+}
+
+void BotInput::clearGoal()
+{
+	hasGoal = false;
+	wander = true;
+	path.clear();
+}
+
+bool BotInput::pickGoal()
+{
+	const NavGraph &nav = level->getNavGraph();
+	if (nav.getNumNodes() == 0) return false;
+
+	/* places that can't be reached are given up on by plan(), and another
+		is picked next tick */
+	goal = nav.getNodePos(random() % nav.getNumNodes());
+	hasGoal = true;
+	sinceProgress = 0;
+	return true;
+}
+
+bool BotInput::plan()
+{
+	sinceReplan = 0;
+	/* the start is where the player is now, give or take a few pixels;
+		it's passed right away unless it's the goal */
+	next = 0;
+
+	if (!level->getNavGraph().findPath(player.getPos(), goal, path))
+	{
+		if (wander) hasGoal = false;
+		return false;
+	}
+
+	return true;
+}
+
+void BotInput::skipAhead()
+{
+	/* while on the ground, walk straight to any later waypoint on the same
+		floor that can be seen */
+	const WallTree &tree = level->getWalls().getTree();
+	const Point &pos = player.getPos();
+
+	while (next + 1 < path.size())
+	{
+		const NavGraph::Waypoint &w = path[next + 1];
+		if (w.link != NavGraph::WALK || fabs(w.pos.y - pos.y) > REACH_STAND ||
+			!tree.lineOfSight(pos, w.pos))
+			break;
+		next++;
+	}
+}
+
+bool BotInput::reached(unsigned int k)
+{
+	const NavGraph::Waypoint &w = path[k];
+	const Point &pos = player.getPos();
+	if (fabs(w.pos.x - pos.x) >= REACH) return false;
+
+	if (w.type != NavGraph::STAND)
+		return fabs(w.pos.y - pos.y) < REACH;
+
+	/* a jump has to start from the ground */
+	if (k + 1 < path.size() && path[k + 1].link == NavGraph::JUMP &&
+		player.isAirborne())
+		return false;
+	return fabs(w.pos.y - pos.y) < REACH_STAND;
+}
+
+int BotInput::steer()
+{
+	const Point &pos = player.getPos();
+
+	/* moving on as each waypoint is reached */
+	while (next < path.size() && reached(next))
+	{
+		next++;
+		sinceProgress = 0;
+	}
+
+	if (next >= path.size())
+	{
+		/* there */
+		path.clear();
+		if (wander) hasGoal = false;
+		return 0;
+	}
+
+	if (!player.isAirborne() && path[next].link == NavGraph::WALK)
+		skipAhead();
+
+	const NavGraph::Waypoint &w = path[next];
+	real dx = w.pos.x - pos.x, dy = w.pos.y - pos.y;
+	int buttons = 0;
+
+	/* head over at the speed that can still stop above it */
+	real speed = pos.x - player.getOldPos().x;
+	real want = std::min((real)sqrt(2 * BRAKE * fabs(dx)), MAX_SPEED);
+	if (dx < 0) want = -want;
+
+	if (fabs(dx) > DEAD_ZONE && speed * want < want * want)
+		buttons |= dx > 0 ? Player::RIGHT : Player::LEFT;
+	else if (fabs(speed) > fabs(want) + BRAKE)
+		buttons |= speed > 0 ? Player::LEFT : Player::RIGHT;
+
+	switch (w.link)
+	{
+	case NavGraph::JUMP:
+		/* jump doesn't do anything until it's let go and pressed again;
+			after that, holding it jumps higher */
+		if (!player.isAirborne())
+		{
+			if (!(lastButtons & Player::JUMP)) buttons |= Player::JUMP;
+		}
+		else if (player.isJumping())
+			buttons |= Player::JUMP;
+		break;
+
+	case NavGraph::LADDER:
+		if (dy < -DEAD_ZONE) buttons |= Player::UP;
+		else if (dy > DEAD_ZONE) buttons |= Player::DOWN;
+		break;
+
+	case NavGraph::WATER:
+		/* swim up with a stroke (a jump) every few ticks, and dive with
+			a tap of down */
+		if (dy < -DEAD_ZONE && !(lastButtons & Player::JUMP))
+			buttons |= Player::JUMP;
+		else if (dy > DEAD_ZONE && !(lastButtons & Player::DOWN))
+			buttons |= Player::DOWN;
+		break;
+
+	default:
+		break;
+	}
+
+	return buttons;
+}
+
+int BotInput::nextButtons()
+{
+	/* a new level makes the old path meaningless */
+	if (bg.getLevel() != level)
+	{
+		level = bg.getLevel();
+		path.clear();
+		if (wander) hasGoal = false;
+	}
+
+	if (level == NULL) return lastButtons = 0;
+	if (!hasGoal && !(wander && pickGoal())) return lastButtons = 0;
+
+	if (++sinceProgress > STUCK_TICKS)
+	{
+		sinceProgress = 0;
+		path.clear();
+		if (wander) hasGoal = false;
+		return lastButtons = 0;
+	}
+
+	/* the time since the last waypoint carries across plans, so a bot
+		going around in circles still gives up */
+	if ((path.empty() || ++sinceReplan > REPLAN_TICKS) && !plan())
+		return lastButtons = 0;
+
+	return lastButtons = steer();
+}
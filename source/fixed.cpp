@@ -0,0 +1,69 @@
+/***************************************************************************
+* SimFun
+*  fixed.cpp -- fixed point numbers, for a deterministic simulation
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include "fixed.h"
+
+static const Fixed PI(3.14159265358979);
+
+Fixed sqrt(const Fixed &a)
+{
+	if (a <= 0) return 0;
+
+	/* sqrt(raw / ONE) * ONE == sqrt(raw * ONE), one bit at a time */
+	Uint64 n = (Uint64)a.getRaw() << Fixed::FRAC_BITS, root = 0;
+	Uint64 bit = (Uint64)1 << 62;
+
+	while (bit > n) bit >>= 2;
+	while (bit)
+	{
+		if (n >= root + bit)
+		{
+			n -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+			root >>= 1;
+		bit >>= 2;
+	}
+
+	return Fixed::fromRaw((Sint64)root);
+}
+
+Fixed atan2(const Fixed &y, const Fixed &x)
+{
+	Fixed ax = fabs(x), ay = fabs(y);
+	if (ax == 0 && ay == 0) return 0;
+
+	/* fold into the first octant, where atan(z) = z*(pi/4 + 0.273*(1-z))
+		is close enough */
+	bool steep = ay > ax;
+	Fixed z = steep ? ax / ay : ay / ax;
+	Fixed a = z * (PI / 4 + Fixed(0.273) * (1 - z));
+
+	if (steep) a = PI / 2 - a;
+	if (x < 0) a = PI - a;
+	if (y < 0) a = -a;
+	return a;
+}
@@ -0,0 +1,477 @@
+/***************************************************************************
+* SimFun
+*  framecapture.cpp -- writes frames to disk on a worker thread
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "framecapture.h"
+#include "misc.h"
+
+/* PNG is written without compression (stored deflate blocks), which is
+	big, but fast enough to keep up with the game */
+static const Uint8 PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+static const unsigned int DEFLATE_BLOCK_SIZE = 65535;
+
+static Uint32 crcTable[256];
+
+static void makeCRCTable()
+{
+	for (Uint32 n = 0; n < 256; n++)
+	{
+		Uint32 c = n;
+		for (int k = 0; k < 8; k++)
+			c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+		crcTable[n] = c;
+	}
+}
+
+static Uint32 crc32(const Uint8 *p, size_t n)
+{
+	Uint32 c = 0xffffffff;
+	for (; n > 0; n--, p++)
+		c = crcTable[(c ^ *p) & 0xff] ^ (c >> 8);
+	return c ^ 0xffffffff;
+}
+
+static Uint32 adler32(const Uint8 *p, size_t n)
+{
+	Uint32 a = 1, b = 0;
+
+	/* 5552 is the most bytes that can be summed before b overflows */
+	while (n > 0)
+	{
+		size_t len = n < 5552 ? n : 5552;
+		n -= len;
+		for (; len > 0; len--, p++)
+		{
+			a += *p;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+
+	return (b << 16) | a;
+}
+
+static void appendU32(std::vector<Uint8> &v, Uint32 x)
+{
+	v.push_back(x >> 24);
+	v.push_back((x >> 16) & 0xff);
+	v.push_back((x >> 8) & 0xff);
+	v.push_back(x & 0xff);
+}
+
+static void appendBytes(std::vector<Uint8> &v, const void *data, size_t n)
+{
+	v.insert(v.end(), (const Uint8 *)data, (const Uint8 *)data + n);
+}
+
+/* drops the alpha */
+static void packRGB(Uint8 *dest, const Uint8 *src, int n)
+{
+	for (; n > 0; n--, src += 4, dest += 3)
+	{
+		dest[0] = src[0];
+		dest[1] = src[1];
+		dest[2] = src[2];
+	}
+}
+
+FrameCapture::FrameCapture():
+	format(UNKNOWN), width(0), height(0), fps(60), current(-1),
+	thread(NULL), lock(NULL), wake(NULL), done(NULL), quit(false),
+	stream(NULL), written(0), failed(false), captured(0), skipped(0)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+	stop();
+}
+
+FrameCapture::Format FrameCapture::getFormat(const char *file)
+{
+	const char *ext = strrchr(file, '.');
+
+	if (ext == NULL) return UNKNOWN;
+	if (strcmp(ext, ".raw") == 0) return RAW;
+	if (strcmp(ext, ".ppm") == 0) return PPM;
+	if (strcmp(ext, ".png") == 0) return PNG;
+	if (strcmp(ext, ".y4m") == 0) return Y4M;
+	return UNKNOWN;
+}
+
+bool FrameCapture::start(const char *file, int _width, int _height, int _fps,
+	int numBuffers)
+{
+	stop();
+
+	format = getFormat(file);
+	if (format == UNKNOWN)
+	{
+		ErrorBox("Can't capture to %s: use .raw, .ppm, .png or .y4m\n", file);
+		return false;
+	}
+
+	width = _width;
+	height = _height;
+	fps = _fps;
+	pattern = file;
+	written = 0;
+	failed = false;
+	captured = skipped = 0;
+
+	if (format == Y4M)
+	{
+		if ((stream = fopen(file, "wb")) == NULL)
+		{
+			ErrorBox("Unable to write %s\n", file);
+			return false;
+		}
+
+		/* 4:2:0 with the chroma samples centered between the luma ones,
+			which is what the conversion in encodeY4M averages */
+		fprintf(stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+	}
+	else
+	{
+		/* the frame number is the only thing that's formatted into the
+			name, so a % that isn't a %d (with an optional width) is an
+			error rather than a crash later */
+		const char *p = strchr(file, '%');
+		if (p == NULL)
+			pattern.insert(pattern.rfind('.'), "%05d");
+		else
+		{
+			const char *q = p + 1;
+			while (*q >= '0' && *q <= '9') q++;
+			if (*q != 'd' || strchr(q, '%') != NULL)
+			{
+				ErrorBox("Can't capture to %s: the name can only have one %%d\n", file);
+				return false;
+			}
+		}
+
+		if (format == RAW && !image.create(width, height)) return false;
+	}
+
+	makeCRCTable();
+
+	for (int i = 0; i < numBuffers; i++)
+	{
+		Uint8 *b = (Uint8 *)malloc(width * height * 4);
+		if (b == NULL)
+		{
+			ErrorBox("Out of memory\n");
+			stop();
+			return false;
+		}
+		buffers.push_back(b);
+		idle.push_back(i);
+	}
+
+	quit = false;
+	lock = SDL_CreateMutex();
+	wake = SDL_CreateCond();
+	done = SDL_CreateCond();
+	thread = SDL_CreateThread(threadFunc, this);
+
+	return true;
+}
+
+void FrameCapture::stop()
+{
+	if (thread)
+	{
+		/* the worker writes everything that's queued before it quits */
+		SDL_mutexP(lock);
+		quit = true;
+		SDL_CondSignal(wake);
+		SDL_mutexV(lock);
+
+		SDL_WaitThread(thread, NULL);
+		thread = NULL;
+	}
+
+	if (stream)
+	{
+		fclose(stream);
+		stream = NULL;
+	}
+
+	for (unsigned int i = 0; i < buffers.size(); i++)
+		free(buffers[i]);
+	buffers.clear();
+	idle.clear();
+	queued.clear();
+	current = -1;
+
+	if (done) SDL_DestroyCond(done);
+	if (wake) SDL_DestroyCond(wake);
+	if (lock) SDL_DestroyMutex(lock);
+	done = wake = NULL;
+	lock = NULL;
+}
+
+Uint8 *FrameCapture::beginFrame(bool wait)
+{
+	if (thread == NULL) return NULL;
+
+	SDL_mutexP(lock);
+
+	while (idle.empty())
+	{
+		if (!wait)
+		{
+			skipped++;
+			SDL_mutexV(lock);
+			return NULL;
+		}
+		SDL_CondWait(done, lock);
+	}
+
+	current = idle.back();
+	idle.pop_back();
+
+	SDL_mutexV(lock);
+
+	return buffers[current];
+}
+
+void FrameCapture::endFrame()
+{
+	if (current < 0) return;
+
+	SDL_mutexP(lock);
+	queued.push_back(current);
+	current = -1;
+	captured++;
+	SDL_CondSignal(wake);
+	SDL_mutexV(lock);
+}
+
+bool FrameCapture::isOK()
+{
+	if (thread == NULL) return !failed;
+
+	SDL_mutexP(lock);
+	bool ok = !failed;
+	SDL_mutexV(lock);
+
+	return ok;
+}
+
+int FrameCapture::threadFunc(void *data)
+{
+	((FrameCapture *)data)->run();
+	return 0;
+}
+
+void FrameCapture::run()
+{
+	SDL_mutexP(lock);
+
+	while (true)
+	{
+		if (queued.empty())
+		{
+			if (quit) break;
+			SDL_CondWait(wake, lock);
+			continue;
+		}
+
+		int n = queued.front();
+		queued.pop_front();
+		bool skip = failed;
+
+		/* convert and write without holding the lock */
+		SDL_mutexV(lock);
+		bool ok = skip || write(buffers[n]);
+		SDL_mutexP(lock);
+
+		if (!ok) failed = true;
+		idle.push_back(n);
+		SDL_CondSignal(done);
+	}
+
+	SDL_mutexV(lock);
+}
+
+bool FrameCapture::write(const Uint8 *rgba)
+{
+	if (format == Y4M)
+	{
+		encodeY4M(rgba);
+		if (fwrite(&encoded[0], 1, encoded.size(), stream) != encoded.size())
+		{
+			ErrorBox("Unable to write %s\n", pattern.c_str());
+			return false;
+		}
+		written++;
+		return true;
+	}
+
+	char name[1024];
+	snprintf(name, sizeof(name), pattern.c_str(), written++);
+
+	if (format == RAW)
+	{
+		for (int j = 0; j < height; j++)
+			packRGB(image.row(j), rgba + j * width * 4, width);
+		return image.saveRaw(name);
+	}
+
+	if (format == PPM)
+	{
+		plane.resize(width * height * 3);
+		for (int j = 0; j < height; j++)
+			packRGB(&plane[j * width * 3], rgba + j * width * 4, width);
+		encodePPM();
+	}
+	else
+	{
+		/* every row starts with its filter type, 0 (none) */
+		int stride = width * 3 + 1;
+		plane.resize(height * stride);
+		for (int j = 0; j < height; j++)
+		{
+			plane[j * stride] = 0;
+			packRGB(&plane[j * stride + 1], rgba + j * width * 4, width);
+		}
+		encodePNG();
+	}
+
+	return writeFile(name, &encoded[0], encoded.size());
+}
+
+bool FrameCapture::writeFile(const char *name, const void *data, size_t size)
+{
+	FILE *f;
+
+	if ((f = fopen(name, "wb")) == NULL)
+	{
+		ErrorBox("Unable to write %s\n", name);
+		return false;
+	}
+
+	bool ok = fwrite(data, 1, size, f) == size;
+	ok = fclose(f) == 0 && ok;
+
+	if (!ok) ErrorBox("Unable to write %s\n", name);
+	return ok;
+}
+
+void FrameCapture::encodePPM()
+{
+	char header[64];
+	int n = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+
+	encoded.clear();
+	appendBytes(encoded, header, n);
+	appendBytes(encoded, &plane[0], plane.size());
+}
+
+void FrameCapture::encodePNG()
+{
+	encoded.clear();
+	appendBytes(encoded, PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
+
+	/* IHDR: 8 bit RGB, not interlaced */
+	size_t start = encoded.size();
+	appendU32(encoded, 13);
+	appendBytes(encoded, "IHDR", 4);
+	appendU32(encoded, width);
+	appendU32(encoded, height);
+	const Uint8 ihdr[5] = { 8, 2, 0, 0, 0 };
+	appendBytes(encoded, ihdr, sizeof(ihdr));
+	appendU32(encoded, crc32(&encoded[start + 4], encoded.size() - start - 4));
+
+	/* IDAT: a zlib stream of stored blocks; the length is filled in after */
+	size_t size = plane.size();
+	size_t blocks = (size + DEFLATE_BLOCK_SIZE - 1) / DEFLATE_BLOCK_SIZE;
+	start = encoded.size();
+	appendU32(encoded, 2 + blocks * 5 + size + 4);
+	appendBytes(encoded, "IDAT", 4);
+	encoded.push_back(0x78);
+	encoded.push_back(0x01);
+
+	for (size_t pos = 0; pos < size; pos += DEFLATE_BLOCK_SIZE)
+	{
+		unsigned int len = size - pos < DEFLATE_BLOCK_SIZE ? size - pos : DEFLATE_BLOCK_SIZE;
+		encoded.push_back(pos + len == size ? 1 : 0);
+		encoded.push_back(len & 0xff);
+		encoded.push_back(len >> 8);
+		encoded.push_back(~len & 0xff);
+		encoded.push_back((~len >> 8) & 0xff);
+		appendBytes(encoded, &plane[pos], len);
+	}
+
+	appendU32(encoded, adler32(&plane[0], size));
+	appendU32(encoded, crc32(&encoded[start + 4], encoded.size() - start - 4));
+
+	appendU32(encoded, 0);
+	appendBytes(encoded, "IEND", 4);
+	appendU32(encoded, crc32((const Uint8 *)"IEND", 4));
+}
+
+void FrameCapture::encodeY4M(const Uint8 *rgba)
+{
+	/* BT.601, limited range, in fixed point. the chroma of each 2x2 block
+		is taken from its average color */
+	int cw = (width + 1) / 2, ch = (height + 1) / 2;
+	static const char FRAME_HEADER[] = "FRAME\n";
+	size_t headerSize = sizeof(FRAME_HEADER) - 1;
+
+	encoded.resize(headerSize + width * height + 2 * cw * ch);
+	memcpy(&encoded[0], FRAME_HEADER, headerSize);
+
+	Uint8 *y = &encoded[headerSize];
+	Uint8 *u = y + width * height, *v = u + cw * ch;
+
+	for (int j = 0; j < height; j++)
+	{
+		const Uint8 *p = rgba + j * width * 4;
+		for (int i = 0; i < width; i++, p += 4)
+			*y++ = ((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16;
+	}
+
+	for (int j = 0; j < ch; j++)
+	{
+		/* odd sizes repeat the last row or column */
+		const Uint8 *row0 = rgba + 2 * j * width * 4;
+		const Uint8 *row1 = 2 * j + 1 < height ? row0 + width * 4 : row0;
+
+		for (int i = 0; i < cw; i++)
+		{
+			int i0 = 2 * i * 4, i1 = 2 * i + 1 < width ? i0 + 4 : i0;
+			int r = (row0[i0] + row0[i1] + row1[i0] + row1[i1] + 2) >> 2;
+			int g = (row0[i0+1] + row0[i1+1] + row1[i0+1] + row1[i1+1] + 2) >> 2;
+			int b = (row0[i0+2] + row0[i1+2] + row1[i0+2] + row1[i1+2] + 2) >> 2;
+
+			*u++ = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+			*v++ = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+		}
+	}
+}
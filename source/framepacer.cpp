@@ -0,0 +1,118 @@
+/***************************************************************************
+* SimFun
+*  framepacer.cpp -- starts frames on a fixed schedule
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <math.h>
+#include "framepacer.h"
+#include "misc.h"
+
+const double FramePacer::SPIN_TIME = 0.002;
+
+FramePacer::FramePacer(double _period):
+	period(_period), vsync(false), deadline(0), lastStart(0)
+{
+	clearStats();
+}
+
+void FramePacer::requestVsync(bool on)
+{
+	SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, on ? 1 : 0);
+}
+
+bool FramePacer::hasVsync()
+{
+	int value = 0;
+	return SDL_GL_GetAttribute(SDL_GL_SWAP_CONTROL, &value) == 0 && value > 0;
+}
+
+void FramePacer::clearStats()
+{
+	frames = late = 0;
+	sum = sumSquares = 0;
+	minTime = maxTime = 0;
+}
+
+void FramePacer::wait()
+{
+	double now = getTime();
+
+	if (deadline == 0)
+		deadline = now;
+	else
+	{
+		deadline += period;
+
+		/* the swap paces frames that are about on time */
+		double target = vsync ? deadline - period / 2 : deadline;
+
+		if (now > deadline + period)
+		{
+			late++;
+			deadline = now;
+		}
+		else if (now > target)
+		{
+			if (now > deadline) late++;
+		}
+		else
+		{
+			double remaining = target - now;
+			if (remaining > SPIN_TIME)
+				SDL_Delay((Uint32)((remaining - SPIN_TIME) * 1000));
+			while (getTime() < target);
+		}
+	}
+
+	double start = getTime();
+	if (lastStart != 0)
+	{
+		double t = start - lastStart;
+		if (frames == 0 || t < minTime) minTime = t;
+		if (frames == 0 || t > maxTime) maxTime = t;
+		sum += t;
+		sumSquares += t * t;
+		frames++;
+	}
+	lastStart = start;
+}
+
+void FramePacer::reset()
+{
+	deadline = lastStart = 0;
+}
+
+void FramePacer::takeStats(Stats &s)
+{
+	s.frames = frames;
+	s.late = late;
+	s.min = minTime;
+	s.max = maxTime;
+	s.average = frames ? sum / frames : 0;
+
+	/* rounding can make the variance a tiny bit negative */
+	double variance = frames ? sumSquares / frames - s.average * s.average : 0;
+	s.deviation = variance > 0 ? sqrt(variance) : 0;
+
+	clearStats();
+}
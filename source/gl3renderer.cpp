@@ -0,0 +1,318 @@
+/***************************************************************************
+* SimFun
+*  gl3renderer.cpp -- draws with shaders and buffers, GL 3.3 core
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdio.h>
+#include "gl3renderer.h"
+#include "misc.h"
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+/* not in the GL 1.1 headers */
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER				0x8892
+#define GL_ELEMENT_ARRAY_BUFFER		0x8893
+#define GL_STREAM_DRAW				0x88E0
+#define GL_STATIC_DRAW				0x88E4
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER			0x8B30
+#define GL_VERTEX_SHADER			0x8B31
+#define GL_COMPILE_STATUS			0x8B81
+#define GL_LINK_STATUS				0x8B82
+#endif
+
+/* the functions past GL 1.1, looked up when the renderer starts */
+static struct
+{
+	GLuint (APIENTRY *CreateShader)(GLenum);
+	void (APIENTRY *ShaderSource)(GLuint, GLsizei, const char **, const GLint *);
+	void (APIENTRY *CompileShader)(GLuint);
+	void (APIENTRY *GetShaderiv)(GLuint, GLenum, GLint *);
+	void (APIENTRY *GetShaderInfoLog)(GLuint, GLsizei, GLsizei *, char *);
+	void (APIENTRY *DeleteShader)(GLuint);
+	GLuint (APIENTRY *CreateProgram)(void);
+	void (APIENTRY *AttachShader)(GLuint, GLuint);
+	void (APIENTRY *LinkProgram)(GLuint);
+	void (APIENTRY *GetProgramiv)(GLuint, GLenum, GLint *);
+	void (APIENTRY *GetProgramInfoLog)(GLuint, GLsizei, GLsizei *, char *);
+	void (APIENTRY *DeleteProgram)(GLuint);
+	void (APIENTRY *UseProgram)(GLuint);
+	GLint (APIENTRY *GetUniformLocation)(GLuint, const char *);
+	void (APIENTRY *Uniform1i)(GLint, GLint);
+	void (APIENTRY *UniformMatrix4fv)(GLint, GLsizei, GLboolean, const GLfloat *);
+	void (APIENTRY *GenBuffers)(GLsizei, GLuint *);
+	void (APIENTRY *DeleteBuffers)(GLsizei, const GLuint *);
+	void (APIENTRY *BindBuffer)(GLenum, GLuint);
+	void (APIENTRY *BufferData)(GLenum, ptrdiff_t, const GLvoid *, GLenum);
+	void (APIENTRY *GenVertexArrays)(GLsizei, GLuint *);
+	void (APIENTRY *DeleteVertexArrays)(GLsizei, const GLuint *);
+	void (APIENTRY *BindVertexArray)(GLuint);
+	void (APIENTRY *EnableVertexAttribArray)(GLuint);
+	void (APIENTRY *VertexAttribPointer)(GLuint, GLint, GLenum, GLboolean, GLsizei, const GLvoid *);
+} gl;
+
+static const char *VERTEX_SHADER =
+	"#version 330 core\n"
+	"uniform mat4 projection;\n"
+	"layout(location = 0) in vec2 position;\n"
+	"layout(location = 1) in vec2 texCoord;\n"
+	"layout(location = 2) in vec4 color;\n"
+	"out vec2 fragTexCoord;\n"
+	"out vec4 fragColor;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = projection * vec4(position, 0.0, 1.0);\n"
+	"	fragTexCoord = texCoord;\n"
+	"	fragColor = color;\n"
+	"}\n";
+
+static const char *FRAGMENT_SHADER =
+	"#version 330 core\n"
+	"uniform sampler2D image;\n"
+	"in vec2 fragTexCoord;\n"
+	"in vec4 fragColor;\n"
+	"out vec4 outColor;\n"
+	"void main()\n"
+	"{\n"
+	"	outColor = texture(image, fragTexCoord) * fragColor;\n"
+	"}\n";
+
+GL3Renderer::GL3Renderer(int _width, int _height):
+	width(_width), height(_height),
+	program(0), vertexArray(0), vertexBuffer(0), indexBuffer(0),
+	indexedQuads(0)
+{
+}
+
+GL3Renderer::~GL3Renderer()
+{
+	/* everything is 0 if the functions weren't found */
+	if (program) gl.DeleteProgram(program);
+	if (vertexBuffer) gl.DeleteBuffers(1, &vertexBuffer);
+	if (indexBuffer) gl.DeleteBuffers(1, &indexBuffer);
+	if (vertexArray) gl.DeleteVertexArrays(1, &vertexArray);
+}
+
+bool GL3Renderer::loadFunctions()
+{
+	int major = 0, minor = 0;
+	const char *version = (const char *)glGetString(GL_VERSION);
+	if (!version || sscanf(version, "%d.%d", &major, &minor) != 2 ||
+		major * 10 + minor < 33)
+		return false;
+
+	struct Proc
+	{
+		const char *name;
+		void **proc;
+	};
+
+	Proc procs[] =
+	{
+		{ "glCreateShader", (void **)&gl.CreateShader },
+		{ "glShaderSource", (void **)&gl.ShaderSource },
+		{ "glCompileShader", (void **)&gl.CompileShader },
+		{ "glGetShaderiv", (void **)&gl.GetShaderiv },
+		{ "glGetShaderInfoLog", (void **)&gl.GetShaderInfoLog },
+		{ "glDeleteShader", (void **)&gl.DeleteShader },
+		{ "glCreateProgram", (void **)&gl.CreateProgram },
+		{ "glAttachShader", (void **)&gl.AttachShader },
+		{ "glLinkProgram", (void **)&gl.LinkProgram },
+		{ "glGetProgramiv", (void **)&gl.GetProgramiv },
+		{ "glGetProgramInfoLog", (void **)&gl.GetProgramInfoLog },
+		{ "glDeleteProgram", (void **)&gl.DeleteProgram },
+		{ "glUseProgram", (void **)&gl.UseProgram },
+		{ "glGetUniformLocation", (void **)&gl.GetUniformLocation },
+		{ "glUniform1i", (void **)&gl.Uniform1i },
+		{ "glUniformMatrix4fv", (void **)&gl.UniformMatrix4fv },
+		{ "glGenBuffers", (void **)&gl.GenBuffers },
+		{ "glDeleteBuffers", (void **)&gl.DeleteBuffers },
+		{ "glBindBuffer", (void **)&gl.BindBuffer },
+		{ "glBufferData", (void **)&gl.BufferData },
+		{ "glGenVertexArrays", (void **)&gl.GenVertexArrays },
+		{ "glDeleteVertexArrays", (void **)&gl.DeleteVertexArrays },
+		{ "glBindVertexArray", (void **)&gl.BindVertexArray },
+		{ "glEnableVertexAttribArray", (void **)&gl.EnableVertexAttribArray },
+		{ "glVertexAttribPointer", (void **)&gl.VertexAttribPointer }
+	};
+
+	for (unsigned int i = 0; i < sizeof(procs) / sizeof(procs[0]); i++)
+		if ((*procs[i].proc = SDL_GL_GetProcAddress(procs[i].name)) == NULL)
+			return false;
+
+	return true;
+}
+
+GLuint GL3Renderer::compile(GLenum type, const char *source)
+{
+	GLuint shader = gl.CreateShader(type);
+	GLint ok;
+
+	gl.ShaderSource(shader, 1, &source, NULL);
+	gl.CompileShader(shader);
+	gl.GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+
+	if (!ok)
+	{
+		char log[1024];
+		gl.GetShaderInfoLog(shader, sizeof(log), NULL, log);
+		ErrorBox("Couldn't compile shader:\n%s\n", log);
+		gl.DeleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+bool GL3Renderer::init()
+{
+	if (!loadFunctions()) return false;
+
+	GLuint vs = compile(GL_VERTEX_SHADER, VERTEX_SHADER);
+	GLuint fs = compile(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+	if (!vs || !fs)
+	{
+		if (vs) gl.DeleteShader(vs);
+		if (fs) gl.DeleteShader(fs);
+		return false;
+	}
+
+	GLint ok;
+	program = gl.CreateProgram();
+	gl.AttachShader(program, vs);
+	gl.AttachShader(program, fs);
+	gl.LinkProgram(program);
+	gl.DeleteShader(vs);
+	gl.DeleteShader(fs);
+	gl.GetProgramiv(program, GL_LINK_STATUS, &ok);
+
+	if (!ok)
+	{
+		char log[1024];
+		gl.GetProgramInfoLog(program, sizeof(log), NULL, log);
+		ErrorBox("Couldn't link shaders:\n%s\n", log);
+		return false;
+	}
+
+	/* screen pixels, upper left at 0,0, to clip space; column major */
+	GLfloat projection[16] =
+	{
+		2.0f / width, 0, 0, 0,
+		0, -2.0f / height, 0, 0,
+		0, 0, -1, 0,
+		-1, 1, 0, 1
+	};
+
+	gl.UseProgram(program);
+	gl.UniformMatrix4fv(gl.GetUniformLocation(program, "projection"), 1, GL_FALSE, projection);
+	gl.Uniform1i(gl.GetUniformLocation(program, "image"), 0);
+	gl.UseProgram(0);
+
+	/* the vertex array remembers the layout and the index buffer */
+	gl.GenVertexArrays(1, &vertexArray);
+	gl.BindVertexArray(vertexArray);
+
+	gl.GenBuffers(1, &vertexBuffer);
+	gl.BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	gl.EnableVertexAttribArray(0);
+	gl.EnableVertexAttribArray(1);
+	gl.EnableVertexAttribArray(2);
+	gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+		(const GLvoid *)offsetof(SpriteVertex, x));
+	gl.VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+		(const GLvoid *)offsetof(SpriteVertex, u));
+	gl.VertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex),
+		(const GLvoid *)offsetof(SpriteVertex, color));
+
+	gl.GenBuffers(1, &indexBuffer);
+	gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	reserveQuads(4096);
+
+	gl.BindVertexArray(0);
+
+	glViewport(0, 0, width, height);
+	glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+	return true;
+}
+
+void GL3Renderer::reserveQuads(int quads)
+{
+	if (quads <= indexedQuads) return;
+
+	/* quads are clockwise, 0 1 2 3; split along 0-2 */
+	indexedQuads = std::max(quads, indexedQuads * 2);
+	indices.resize(indexedQuads * 6);
+	for (int q = 0; q < indexedQuads; q++)
+	{
+		GLuint *i = &indices[q * 6], v = q * 4;
+		i[0] = v; i[1] = v + 1; i[2] = v + 2;
+		i[3] = v; i[4] = v + 2; i[5] = v + 3;
+	}
+
+	gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+		&indices[0], GL_STATIC_DRAW);
+}
+
+void GL3Renderer::clear()
+{
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void GL3Renderer::draw(Primitive type, GLuint texture, const SpriteVertex *v,
+	int n, bool blend)
+{
+	if (n == 0) return;
+
+	gl.UseProgram(program);
+	gl.BindVertexArray(vertexArray);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	if (blend)
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+
+	/* new storage every time, so the driver doesn't have to wait until
+		the last draw is done with the old one */
+	gl.BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	gl.BufferData(GL_ARRAY_BUFFER, n * sizeof(SpriteVertex), v, GL_STREAM_DRAW);
+
+	if (type == QUADS)
+	{
+		reserveQuads(n / 4);
+		glDrawElements(GL_TRIANGLES, n / 4 * 6, GL_UNSIGNED_INT, NULL);
+	}
+	else
+		glDrawArrays(GL_LINES, 0, n);
+
+	glDisable(GL_BLEND);
+	gl.BindVertexArray(0);
+	gl.UseProgram(0);
+}
@@ -0,0 +1,348 @@
+/***************************************************************************
+* SimFun
+*  image.cpp -- loads bitmaps straight into the layout GL wants
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "image.h"
+#include "misc.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#define USE_WIN32_MAPPING
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(__native_client__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define USE_MMAP
+#endif
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+/* header of the raw format: magic, width, height (little endian), followed
+	by the pixels exactly as they are in memory */
+static const char RAW_MAGIC[4] = { 'S', 'F', 'R', 'W' };
+static const unsigned int RAW_HEADER_SIZE = 12;
+/* bigger than any texture we'd upload; anything past it is a bad file, and
+	keeping to it means w * h * 3 can't overflow */
+static const int MAX_IMAGE_SIZE = 16384;
+
+static unsigned int readU16(const Uint8 *p) { return p[0] | (p[1] << 8); }
+static unsigned int readU32(const Uint8 *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24); }
+
+static void writeU32(Uint8 *p, unsigned int v)
+{
+	p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = v >> 24;
+}
+
+/* read-only view of a whole file; mapped where the OS supports it, so the
+	decoder reads straight out of the page cache */
+class MappedFile
+{
+/* fields */
+private:
+	const Uint8 *data;
+	unsigned int size;
+	Uint8 *buffer;
+#if defined(USE_WIN32_MAPPING)
+	HANDLE file, mapping;
+#elif defined(USE_MMAP)
+	int fd;
+#endif
+
+/* constructors */
+public:
+	MappedFile(const char *name);
+	~MappedFile();
+
+/* methods */
+private:
+	bool read(const char *name);
+
+/* getters */
+public:
+	const Uint8 * getData() const { return data; }
+	unsigned int getSize() const { return size; }
+};
+
+MappedFile::MappedFile(const char *name):
+	data(NULL), size(0), buffer(NULL)
+{
+#if defined(USE_WIN32_MAPPING)
+	mapping = NULL;
+	file = CreateFile(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		size = GetFileSize(file, NULL);
+		mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping)
+			data = (const Uint8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+#elif defined(USE_MMAP)
+	struct stat st;
+	fd = open(name, O_RDONLY);
+	if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED)
+		{
+			data = (const Uint8 *)p;
+			size = st.st_size;
+		}
+	}
+#endif
+
+	/* mapping isn't available (or failed), just read it */
+	if (data == NULL) read(name);
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(USE_WIN32_MAPPING)
+	if (data && !buffer) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#elif defined(USE_MMAP)
+	if (data && !buffer) munmap((void *)data, size);
+	if (fd >= 0) close(fd);
+#endif
+	free(buffer);
+}
+
+bool MappedFile::read(const char *name)
+{
+	FILE *f;
+	long len;
+
+	if ((f = fopen(name, "rb")) == NULL) return false;
+
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	if (len > 0 && (buffer = (Uint8 *)malloc(len)) != NULL &&
+		fread(buffer, 1, len, f) == (size_t)len)
+	{
+		data = buffer;
+		size = len;
+	}
+
+	fclose(f);
+	return data != NULL;
+}
+
+Image::Image(const Image &i):
+	w(0), h(0), pixels(NULL)
+{
+	*this = i;
+}
+
+Image::~Image()
+{
+	free(pixels);
+}
+
+Image &Image::operator =(const Image &i)
+{
+	/* an empty image has no pixels to copy */
+	if (this != &i && create(i.w, i.h) && i.pixels)
+		memcpy(pixels, i.pixels, w * h * 3);
+	return *this;
+}
+
+bool Image::create(int _w, int _h)
+{
+	free(pixels);
+	pixels = NULL;
+	w = h = 0;
+
+	/* rows are indexed with ints, so w * h * 3 has to fit in one; checked
+		by division, so a huge image fails instead of wrapping */
+	size_t size = 0;
+	if (_w >= 0 && _h >= 0 && (_w == 0 || _h <= (INT_MAX - 1) / 3 / _w))
+	{
+		w = _w;
+		h = _h;
+		size = (size_t)w * h * 3 + 1;
+	}
+
+	if (size == 0 || (pixels = (Uint8 *)malloc(size)) == NULL)
+	{
+		w = h = 0;
+		ErrorBox("Out of memory\n");
+		return false;
+	}
+	return true;
+}
+
+void Image::fill(Uint8 value)
+{
+	memset(pixels, value, w * h * 3);
+}
+
+void Image::swizzle(Uint8 *dest, const Uint8 *src, int n)
+{
+#ifdef __SSSE3__
+	/* 5 pixels (15 bytes) per shuffle; the 16th byte is copied as is, and
+		is overwritten by the next iteration. stop while there are still 6
+		pixels left, so the 16 byte loads and stores never leave the row */
+	const __m128i mask = _mm_setr_epi8(2,1,0, 5,4,3, 8,7,6, 11,10,9, 14,13,12, 15);
+	for (; n >= 6; n -= 5, src += 15, dest += 15)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)src);
+		_mm_storeu_si128((__m128i *)dest, _mm_shuffle_epi8(v, mask));
+	}
+#endif
+
+	for (; n > 0; n--, src += 3, dest += 3)
+	{
+		Uint8 r = src[2], g = src[1], b = src[0];
+		dest[0] = r;
+		dest[1] = g;
+		dest[2] = b;
+	}
+}
+
+bool Image::decodeBMP(const Uint8 *data, unsigned int size, const char *file)
+{
+	/* BITMAPFILEHEADER (14 bytes) + BITMAPINFOHEADER (40 bytes) */
+	if (size < 54)
+	{
+		ErrorBox("Unable to load %s: truncated header\n", file);
+		return false;
+	}
+
+	unsigned int offset = readU32(data + 10);
+	int width = (int)readU32(data + 18);
+	int height = (int)readU32(data + 22);
+	unsigned int bpp = readU16(data + 28);
+	unsigned int compression = readU32(data + 30);
+
+	if (bpp != 24 || compression != 0)
+	{
+		ErrorBox("Unable to load %s: only uncompressed 24 bit bitmaps are supported\n", file);
+		return false;
+	}
+
+	if (width <= 0 || width > MAX_IMAGE_SIZE || height == 0 ||
+		height > MAX_IMAGE_SIZE || height < -MAX_IMAGE_SIZE)
+	{
+		ErrorBox("Unable to load %s: bad size\n", file);
+		return false;
+	}
+
+	/* negative height means the rows are stored top to bottom */
+	bool bottomUp = height > 0;
+	if (!bottomUp) height = -height;
+
+	unsigned int stride = (width * 3 + 3) & ~3;
+	if (offset > size || (unsigned int)height > (size - offset) / stride)
+	{
+		ErrorBox("Unable to load %s: truncated image\n", file);
+		return false;
+	}
+
+	if (!create(width, height)) return false;
+
+	/* BMP rows are BGR and (usually) upside down -- both get fixed in the
+		same pass that copies them out of the file */
+	for (int j = 0; j < height; j++)
+	{
+		const Uint8 *src = data + offset + j * stride;
+		swizzle(row(bottomUp ? height - 1 - j : j), src, width);
+	}
+
+	return true;
+}
+
+bool Image::decodeRaw(const Uint8 *data, unsigned int size, const char *file)
+{
+	int width = (int)readU32(data + 4), height = (int)readU32(data + 8);
+
+	if (width <= 0 || width > MAX_IMAGE_SIZE || height <= 0 || height > MAX_IMAGE_SIZE)
+	{
+		ErrorBox("Unable to load %s: bad size\n", file);
+		return false;
+	}
+
+	if ((unsigned int)height > (size - RAW_HEADER_SIZE) / (width * 3))
+	{
+		ErrorBox("Unable to load %s: truncated image\n", file);
+		return false;
+	}
+
+	if (!create(width, height)) return false;
+
+	/* already in the right layout */
+	memcpy(pixels, data + RAW_HEADER_SIZE, width * height * 3);
+	return true;
+}
+
+bool Image::load(const char *file)
+{
+	MappedFile f(file);
+	const Uint8 *data = f.getData();
+	unsigned int size = f.getSize();
+
+	if (data == NULL)
+	{
+		ErrorBox("Unable to load %s\n", file);
+		return false;
+	}
+
+	if (size >= RAW_HEADER_SIZE && memcmp(data, RAW_MAGIC, 4) == 0)
+		return decodeRaw(data, size, file);
+	if (size >= 2 && data[0] == 'B' && data[1] == 'M')
+		return decodeBMP(data, size, file);
+
+	ErrorBox("Unable to load %s: unknown format\n", file);
+	return false;
+}
+
+bool Image::saveRaw(const char *file) const
+{
+	FILE *f;
+	Uint8 header[RAW_HEADER_SIZE];
+
+	memcpy(header, RAW_MAGIC, 4);
+	writeU32(header + 4, w);
+	writeU32(header + 8, h);
+
+	if ((f = fopen(file, "wb")) == NULL)
+	{
+		ErrorBox("Unable to write %s\n", file);
+		return false;
+	}
+
+	bool ok = fwrite(header, 1, RAW_HEADER_SIZE, f) == RAW_HEADER_SIZE &&
+		fwrite(pixels, 1, w * h * 3, f) == (size_t)(w * h * 3);
+	fclose(f);
+
+	return ok;
+}
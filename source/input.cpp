@@ -0,0 +1,221 @@
+/***************************************************************************
+* SimFun
+*  input.cpp -- where the player's buttons come from
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "input.h"
+#include "misc.h"
+#include "player.h"
+
+/* replay file: magic, map, random state, number of ticks (little endian),
+	then the buttons of each tick, a byte each */
+static const char REPLAY_MAGIC[4] = { 'S', 'F', 'R', 'P' };
+static const unsigned int REPLAY_HEADER_SIZE = 16;
+
+static unsigned int readU32(const Uint8 *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24); }
+
+static void writeU32(Uint8 *p, unsigned int v)
+{
+	p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = v >> 24;
+}
+
+int KeyboardInput::getButton(SDLKey key)
+{
+	switch (key)
+	{
+	case SDLK_UP: return Player::UP;
+	case SDLK_DOWN: return Player::DOWN;
+	case SDLK_LEFT: return Player::LEFT;
+	case SDLK_RIGHT: return Player::RIGHT;
+	case SDLK_SPACE: return Player::JUMP;
+	default: return 0;
+	}
+}
+
+bool KeyboardInput::handleEvent(const SDL_Event &event)
+{
+	if (event.type != SDL_KEYDOWN && event.type != SDL_KEYUP) return false;
+
+	int button = getButton(event.key.keysym.sym);
+	if (button == 0) return false;
+
+	/* nothing is taking them; the oldest has waited long enough */
+	if (events.size() >= MAX_EVENTS)
+	{
+		if (events[0].down) held |= events[0].button;
+		else held &= ~events[0].button;
+		events.erase(events.begin());
+	}
+
+	KeyEvent e;
+	e.time = getTime();
+	e.button = button;
+	e.down = event.type == SDL_KEYDOWN;
+	events.push_back(e);
+
+	return true;
+}
+
+void KeyboardInput::reset()
+{
+	events.clear();
+	held = 0;
+}
+
+int KeyboardInput::nextButtons()
+{
+	int pressed = 0, released = 0;
+	double now = getTime();
+
+	unsigned int n;
+	for (n = 0; n < events.size(); n++)
+	{
+		const KeyEvent &e = events[n];
+
+		if (e.down)
+		{
+			/* the button already changed this tick; if this press went in
+				too, the player would never see it */
+			if ((pressed | released) & e.button) break;
+			held |= e.button;
+			pressed |= e.button;
+		}
+		else
+		{
+			held &= ~e.button;
+			released |= e.button;
+		}
+
+		latencySum += now - e.time;
+		latencyCount++;
+	}
+	events.erase(events.begin(), events.begin() + n);
+
+	/* a button that was pressed and let go since the last tick is down
+		for this one */
+	return held | pressed;
+}
+
+double KeyboardInput::takeLatency()
+{
+	double latency = latencyCount ? latencySum / latencyCount : 0;
+	latencySum = 0;
+	latencyCount = 0;
+	return latency;
+}
+
+ScriptInput::ScriptInput(const Step *_steps, int _numSteps):
+	steps(_steps), numSteps(_numSteps), length(0), tick(0)
+{
+	for (int i = 0; i < numSteps; i++)
+		length += steps[i].ticks;
+}
+
+int ScriptInput::nextButtons()
+{
+	int t = tick++ % length;
+
+	for (int i = 0; i < numSteps; i++)
+	{
+		if (t < steps[i].ticks)
+		{
+			if (steps[i].hop && t % 30 >= 12)
+				return steps[i].buttons & ~Player::JUMP;
+			return steps[i].buttons;
+		}
+		t -= steps[i].ticks;
+	}
+
+	return 0;
+}
+
+int RecordInput::nextButtons()
+{
+	int b = source->nextButtons();
+	buttons.push_back(b);
+	return b;
+}
+
+bool RecordInput::save(const char *file) const
+{
+	FILE *f;
+	Uint8 header[REPLAY_HEADER_SIZE];
+
+	memcpy(header, REPLAY_MAGIC, 4);
+	writeU32(header + 4, map);
+	writeU32(header + 8, randomState);
+	writeU32(header + 12, buttons.size());
+
+	if ((f = fopen(file, "wb")) == NULL)
+	{
+		ErrorBox("Unable to write %s\n", file);
+		return false;
+	}
+
+	bool ok = fwrite(header, 1, REPLAY_HEADER_SIZE, f) == REPLAY_HEADER_SIZE &&
+		(buttons.empty() || fwrite(&buttons[0], 1, buttons.size(), f) == buttons.size());
+	ok = fclose(f) == 0 && ok;
+
+	if (!ok) ErrorBox("Unable to write %s\n", file);
+	return ok;
+}
+
+bool ReplayInput::load(const char *file)
+{
+	FILE *f;
+	Uint8 header[REPLAY_HEADER_SIZE];
+
+	if ((f = fopen(file, "rb")) == NULL)
+	{
+		ErrorBox("Unable to load %s\n", file);
+		return false;
+	}
+
+	bool ok = fread(header, 1, REPLAY_HEADER_SIZE, f) == REPLAY_HEADER_SIZE &&
+		memcmp(header, REPLAY_MAGIC, 4) == 0;
+	if (ok)
+	{
+		map = readU32(header + 4);
+		randomState = readU32(header + 8);
+		buttons.resize(readU32(header + 12));
+		ok = buttons.empty() || fread(&buttons[0], 1, buttons.size(), f) == buttons.size();
+	}
+	fclose(f);
+
+	if (!ok)
+	{
+		ErrorBox("Unable to load %s: not a replay, or truncated\n", file);
+		buttons.clear();
+		return false;
+	}
+
+	tick = 0;
+	return true;
+}
+
+int ReplayInput::nextButtons()
+{
+	return tick < buttons.size() ? buttons[tick++] : 0;
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+* SimFun
+*  layercache.cpp -- keeps the layers that don't move in a texture
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include "layercache.h"
+#include "renderer.h"
+
+LayerCache::LayerCache(int _width, int _height):
+	texture(0), width(_width), height(_height), texWidth(1), texHeight(1),
+	layers(-1)
+{
+	while (texWidth < width) texWidth <<= 1;
+	while (texHeight < height) texHeight <<= 1;
+}
+
+LayerCache::~LayerCache()
+{
+	if (texture) glDeleteTextures(1, &texture);
+}
+
+void LayerCache::capture(int _layers)
+{
+	if (texture == 0)
+	{
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		/* drawn 1:1 on pixel centers, so no filtering is needed */
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, texWidth, texHeight, 0, GL_RGB,
+			GL_UNSIGNED_BYTE, NULL);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glReadBuffer(GL_BACK);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+	layers = _layers;
+}
+
+void LayerCache::draw(Renderer &renderer) const
+{
+	/* the framebuffer's first row is the bottom of the screen, so the
+		texture is upside down */
+	float u = width / (float)texWidth, v = height / (float)texHeight;
+	float w = (float)width, h = (float)height;
+	Color white(255,255,255,255);
+
+	SpriteVertex quad[4] =
+	{
+		{ 0, 0, 0, v, white },
+		{ 0, h, 0, 0, white },
+		{ w, h, u, 0, white },
+		{ w, 0, u, v, white }
+	};
+
+	renderer.draw(Renderer::QUADS, texture, quad, 4, false);
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+* SimFun
+*  legacyrenderer.cpp -- draws with fixed function GL 1.x
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include "legacyrenderer.h"
+
+LegacyRenderer::LegacyRenderer(int width, int height)
+{
+	glViewport(0, 0, width, height);
+	glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	gluOrtho2D(0, width, height, 0);
+
+	glMatrixMode(GL_MODELVIEW);
+}
+
+void LegacyRenderer::clear()
+{
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void LegacyRenderer::draw(Primitive type, GLuint texture,
+	const SpriteVertex *v, int n, bool blend)
+{
+	if (n == 0) return;
+
+	/* GL_MODULATE with a white vertex color gives the same result as
+		GL_DECAL for the opaque images, and a white texel times the vertex
+		color gives a flat colored quad or line */
+	glEnable(GL_TEXTURE_2D);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	if (blend)
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+
+	glVertexPointer(2, GL_FLOAT, sizeof(SpriteVertex), &v->x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(SpriteVertex), &v->u);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(SpriteVertex), &v->color);
+
+	glDrawArrays(type == QUADS ? GL_QUADS : GL_LINES, 0, n);
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glDisable(GL_BLEND);
+	glDisable(GL_TEXTURE_2D);
+}
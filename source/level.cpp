@@ -0,0 +1,235 @@
+/***************************************************************************
+* SimFun
+*  level.cpp -- builds tiles, walls and regions from a map file
+* Copyright (C) 2004	Ben Smith
+* 
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+* 
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include "SDL.h"
+#include "SDL_thread.h"
+#include "alloctrack.h"
+#include "level.h"
+#include "misc.h"
+#include "navgraph.h"
+#include "walls.h"
+
+/* enough for the shipped maps in one block */
+const size_t Level::ARENA_BLOCK_SIZE = 1024 * 1024;
+int Level::threads = 4;
+
+bool Level::readMapFromFile(const char *file)
+{
+	FILE *f;
+	
+	if ((f = fopen(file,"rb")) == NULL)
+	{
+		ErrorBox("Can't open map: \"%s\"",file);
+		return false;
+	}
+
+	map = allocate<Tile::TileType>(tileWidth * tileHeight);
+
+	int i = 0;
+	int c;
+
+	while (!feof(f) && i < tileWidth * tileHeight)
+	{
+		c = tolower(fgetc(f));
+
+		if (isalpha(c) && c - 'a' + 10 < Tile::MAX_TILE_TYPES)
+			map[i++] = (Tile::TileType)(c - 'a' + 10);
+		else if (isdigit(c) && c - '0' < Tile::MAX_TILE_TYPES)
+			map[i++] = (Tile::TileType)(c - '0');
+		else if (c == '\n' || c == '\r')
+			;
+		else
+		{
+			ErrorBox("Error reading map: \"%s\"",file);
+			fclose(f);
+			return false;
+		}
+	}
+	
+	fclose(f);
+	return true;
+}
+
+bool Level::load(const char *file, const Physics &physics)
+{
+	if (!readMapFromFile(file)) return false;
+	tilemap = new (allocate<TileMap>()) TileMap(tileWidth, tileHeight, arena);
+
+	/* the fill only needs the map, so it's done while the walls are
+		merged; the regions get their walls once those are done */
+	tileRegion = allocate<int>(tileWidth * tileHeight);
+	SDL_Thread *filler = NULL;
+	if (threads > 1)
+	{
+		fillArena = arena.fork();
+		filler = SDL_CreateThread(fillThread, this);
+	}
+	if (filler == NULL) fillRegions();
+
+	walls = new (allocate<Walls>()) Walls(*this);
+
+	if (filler) SDL_WaitThread(filler, NULL);
+	if (fillArena) arena.join(fillArena);
+	fillArena = NULL;
+
+	mapRegions();
+	nav = new (allocate<NavGraph>()) NavGraph(&arena);
+	nav->build(*this, physics);
+	return true;
+}
+
+int Level::fillThread(void *data)
+{
+	Level *level = (Level *)data;
+
+	AllocTracker::setTag(AllocTracker::LOADER);
+	level->fillArena->attach();
+	level->fillRegions();
+	Arena::detach();
+	return 0;
+}
+
+void Level::clearTileRegion()
+{
+	for (int i= 0; i< tileWidth * tileHeight; i++)
+		tileRegion[i] = -1;
+}
+
+void Level::paintIndex(int region, int i, int j)
+{
+	tileRegion[i + j*tileWidth] = region;
+}
+
+bool Level::checkIndex(int i, int j, Tile::TileType type)
+{
+	return mapIndex(i, j) == type && tileRegion[i + j*tileWidth] < 0;
+}
+
+/* Paul Heckbert's Seed Fill algorithm/code */
+/********************************************************/
+/*
+ * A Seed Fill Algorithm
+ * by Paul Heckbert
+ * from "Graphics Gems", Academic Press, 1990
+ ...
+ * Paul Heckbert	13 Sept 1982, 28 Jan 1987
+ */
+/********************************************************/
+
+void Level::regionFill(int region, Tile::TileType type, int i, int j)
+{
+	Allocator<Strip> alloc(&arena);
+	StripStack stack((StripStack::container_type(alloc)));
+
+	stack.push(Strip(i,i,j,1));
+	stack.push(Strip(i,i,j+1,-1));
+
+	while (!stack.empty())
+	{
+		int x, l;
+		Strip s = stack.top(); stack.pop();
+		s.y += s.dy;
+		if (s.y < 0 || s.y >= tileHeight) continue;
+
+		for (x = s.xl; x >= 0 && checkIndex(x, s.y, type); --x)
+			paintIndex(region, x, s.y);
+
+		if (x >= s.xl) goto skip;
+		l = x + 1;
+		if (l < s.xl) stack.push(Strip(l, s.xl-1, s.y, -s.dy));
+		x = s.xl + 1;
+		do
+		{
+			for (; x < tileWidth && checkIndex(x, s.y, type); ++x)
+				paintIndex(region, x, s.y);
+
+			stack.push(Strip(l, x-1, s.y, s.dy));
+			if (x > s.xr+1) stack.push(Strip(s.xr + 1, x - 1, s.y, -s.dy));
+
+skip:		for (x++; x <= s.xr && mapIndex(x, s.y) != type; ++x);
+			l = x;
+		}
+		while (x <= s.xr);
+	}
+}
+
+void Level::fillRegions()
+{
+	clearTileRegion();
+
+	/* basic idea:
+		* iterate over all tiles
+		* find ladder or water tile
+		* use fill algorithm (above) to map tiles to region
+		* add walls from tile to region (mapRegions, once there are walls)
+		* profit
+	*/
+
+	for (int j= 0; j< tileHeight; j++)
+		for (int i= 0; i < tileWidth; i++)
+		{
+			Tile::TileType type = mapIndex(i,j);
+			if (tileRegion[i + j*tileWidth] >= 0) continue;
+			if (type != Tile::WATER && type != Tile::LADDER) continue;
+
+			regionFill(numRegions++, type, i,j);
+		}
+}
+
+void Level::mapRegions()
+{
+	regions = new (allocate<Region::List>())
+		Region::List(Region::List::allocator_type(&arena));
+
+	/* a region is filled from its first tile, so they're found here in
+		the order they were numbered */
+	std::vector<Region *, Allocator<Region *> > numbered((Allocator<Region *>(&arena)));
+	numbered.reserve(numRegions);
+
+	for (int j= 0; j< tileHeight; j++)
+		for (int i= 0; i < tileWidth; i++)
+		{
+			int r = tileRegion[i + j*tileWidth];
+			if (r < 0) continue;
+
+			if (r == (int)numbered.size())
+			{
+				regions->push_back(Region(mapIndex(i,j), &arena));
+				numbered.push_back(&regions->back());
+			}
+
+			TileMapEntry *tme = tilemap->index(i,j);
+			numbered[r]->addFromTile(tme);
+			tme->setRegion(numbered[r]);
+		}
+
+	Region::ListIterator r;
+	for (r = regions->begin(); r != regions->end(); ++r)
+		(*r).buildBatch();
+
+	/* it's only needed while loading; the arena frees it with the rest */
+	tileRegion = NULL;
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+/***************************************************************************
+* SimFun
+*  maploader.cpp -- builds levels on a worker thread
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+#include "SDL.h"
+#include "SDL_thread.h"
+#include "alloctrack.h"
+#include "level.h"
+#include "maploader.h"
+#include "tiles.h"
+
+MapLoader::MapLoader(int _tileWidth, int _tileHeight):
+	thread(NULL), lock(NULL), wake(NULL), quit(false),
+	tileWidth(_tileWidth), tileHeight(_tileHeight),
+	requestId(0), pending(false), working(false),
+	result(NULL), resultId(0)
+{
+}
+
+MapLoader::~MapLoader()
+{
+	if (thread)
+	{
+		SDL_mutexP(lock);
+		quit = true;
+		SDL_CondSignal(wake);
+		SDL_mutexV(lock);
+
+		SDL_WaitThread(thread, NULL);
+	}
+
+	if (result) delete result;
+	if (wake) SDL_DestroyCond(wake);
+	if (lock) SDL_DestroyMutex(lock);
+}
+
+void MapLoader::start()
+{
+	/* Tiles is a function static singleton; make sure it's constructed
+		here, rather than racing to construct it on the worker */
+	Tiles::get();
+
+	lock = SDL_CreateMutex();
+	wake = SDL_CreateCond();
+	thread = SDL_CreateThread(threadFunc, this);
+}
+
+int MapLoader::threadFunc(void *data)
+{
+	((MapLoader *)data)->run();
+	return 0;
+}
+
+void MapLoader::run()
+{
+	AllocTracker::setTag(AllocTracker::LOADER);
+	SDL_mutexP(lock);
+
+	while (!quit)
+	{
+		if (!pending)
+		{
+			SDL_CondWait(wake, lock);
+			continue;
+		}
+
+		std::string file = requestFile;
+		int id = requestId;
+		Physics physics = requestPhysics;
+		pending = false;
+		working = true;
+
+		/* the slow part: parse, build walls and map regions, without
+			holding the lock */
+		SDL_mutexV(lock);
+
+		Level *level = new Level(tileWidth, tileHeight);
+		if (!level->load(file.c_str(), physics))
+		{
+			delete level;
+			level = NULL;
+		}
+
+		SDL_mutexP(lock);
+		working = false;
+
+		/* a newer level replaces one that was never picked up */
+		if (level)
+		{
+			if (result) delete result;
+			result = level;
+			resultId = id;
+		}
+	}
+
+	SDL_mutexV(lock);
+}
+
+void MapLoader::request(const char *file, int id, const Physics &physics)
+{
+	SDL_mutexP(lock);
+	requestFile = file;
+	requestId = id;
+	requestPhysics = physics;
+	pending = true;
+	SDL_CondSignal(wake);
+	SDL_mutexV(lock);
+}
+
+Level *MapLoader::poll(int &id)
+{
+	Level *level;
+
+	SDL_mutexP(lock);
+	level = result;
+	id = resultId;
+	result = NULL;
+	SDL_mutexV(lock);
+
+	return level;
+}
+
+bool MapLoader::busy()
+{
+	bool b;
+
+	SDL_mutexP(lock);
+	b = pending || working || result != NULL;
+	SDL_mutexV(lock);
+
+	return b;
+}
\ No newline at end of file
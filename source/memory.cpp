@@ -0,0 +1,40 @@
+/***************************************************************************
+* SimFun
+*  memory.cpp -- the default memory resource
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include "memory.h"
+
+class HeapResource : public MemoryResource
+{
+/* methods */
+public:
+	void *allocate(size_t n, size_t align) { return ::operator new(n); }
+	void deallocate(void *p, size_t n) { ::operator delete(p); }
+};
+
+MemoryResource *MemoryResource::getDefault()
+{
+	static HeapResource heap;
+	return &heap;
+}
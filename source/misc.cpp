@@ -1,8 +1,7 @@
 /***************************************************************************
 * SimFun
-*  misc.cpp -- miscellaneous functions for loading bitmaps, errors, etc.
+*  misc.cpp -- miscellaneous functions for errors, random numbers, etc.
 * Copyright (C) 2004	Ben Smith
-*	(except where shown below)
 * 
 * This program is free software; you can redistribute it and/or
 * modify it under the terms of the GNU General Public License
@@ -30,117 +29,84 @@
 #include "SDL.h"
 #include "misc.h"
 
-/*  loadBMP(const char *filename)
-	fixImage(SDL_Surface *src)
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
 
-  taken from NeHe OpenGL tutorial ported to SDL: */
+void ErrorBox(const char *format, ...)
+{
+	char buffer[255];
+	va_list marker;
+	va_start(marker, format);
+	_vsnprintf(buffer, 255-1, format, marker);
+	va_end(marker);
+	MessageBox(NULL,buffer,"Error",MB_OK);
+}
 
-/********************************************************/
-//
-// This code was created by Jeff Molofee '99
-// (ported to SDL by Sam Lantinga '2000)
-//
-// If you've found this code useful, please let me know.
-//
-// Visit me at www.demonews.com/hosted/nehe 
-/********************************************************/
+/* the C library's rand() can't be saved and restored, so use a simple
+	LCG (the constants are from Numerical Recipes) */
+static Uint32 randomState = 1;
 
-SDL_Surface *loadBMP(const char *filename)
+real frand()
 {
-    SDL_Surface *image;
-
-    image = SDL_LoadBMP(filename);
-    if ( image == NULL ) {
-        ErrorBox("Unable to load %s: %s\n", filename, SDL_GetError());
-        return(NULL);
-    }
-    return(image);
+	randomState = randomState * 1664525 + 1013904223;
+	/* the top 24 bits are the most random, and fit a float exactly */
+#ifdef SIMFUN_FIXED_POINT
+	return Fixed::fromRaw((Sint64)(randomState >> 8) * Fixed::ONE / 0xffffff);
+#else
+	return (float)(randomState >> 8) / 0xffffff;
+#endif
 }
 
-SDL_Surface *fixImage(SDL_Surface *src)
+Uint32 getRandomState()
 {
-    Uint8 *rowhi, *rowlo;
-    Uint8 *tmpbuf, tmpch;
-	int i, j;
-
-    /* GL surfaces are upsidedown and RGB, not BGR :-) */
-    tmpbuf = (Uint8 *)malloc(src->pitch);
-    if ( tmpbuf == NULL ) {
-        ErrorBox("Out of memory\n");
-        return(NULL);
-    }
-
-	if (SDL_MUSTLOCK(src) != 0) SDL_LockSurface(src);
-
-    rowhi = (Uint8 *)src->pixels;
-    rowlo = rowhi + (src->h * src->pitch) - src->pitch;
-    for ( i=0; i<src->h/2; ++i ) {
-        for ( j=0; j<src->w; ++j ) {
-            tmpch = rowhi[j*3];
-            rowhi[j*3] = rowhi[j*3+2];
-            rowhi[j*3+2] = tmpch;
-            tmpch = rowlo[j*3];
-            rowlo[j*3] = rowlo[j*3+2];
-            rowlo[j*3+2] = tmpch;
-        }
-        memcpy(tmpbuf, rowhi, src->pitch);
-        memcpy(rowhi, rowlo, src->pitch);
-        memcpy(rowlo, tmpbuf, src->pitch);
-        rowhi += src->pitch;
-        rowlo -= src->pitch;
-    }
-
-	if (SDL_MUSTLOCK(src) != 0) SDL_UnlockSurface(src);
-
-    free(tmpbuf);
-
-	return src;
+	return randomState;
 }
 
-SDL_Surface *makeTexture(SDL_Surface *src)
+void setRandomState(Uint32 state)
 {
-	SDL_Surface *dest;
-	int b;
-	int w, h;
-
-	/* expand width and height to power of 2 */
-	for (b= 1; b != 0; b <<= 1)
-		if (src->w <= b)
-		{
-			w = b;
-			break;
-		}
-	
-	for (b= 1; b != 0; b <<= 1)
-		if (src->h <= b)
-		{
-			h = b;
-			break;
-		}
-
-	dest = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 24, 0xff, 0xff00, 0xff0000, 0);
-	if (dest == NULL)
-	{
-        ErrorBox("Unable to make texture.\n");
-        return(NULL);
-	}
-
-	if (SDL_BlitSurface(src, NULL, dest, NULL) != 0) return NULL;
-	SDL_FreeSurface(src);
-	return dest;
+	randomState = state;
 }
 
-void ErrorBox(const char *format, ...)
+double getTime()
 {
-	char buffer[255];
-	va_list marker;
-	va_start(marker, format);
-	_vsnprintf(buffer, 255-1, format, marker);
-	va_end(marker);
-	MessageBox(NULL,buffer,"Error",MB_OK);
+#if defined(_WIN32)
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (double)count.QuadPart / freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+#endif
 }
 
-float frand()
+long getPeakMemory()
 {
-	return (float)rand()/RAND_MAX;
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return (long)pmc.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+	/* bytes on OS X, kilobytes everywhere else */
+	return usage.ru_maxrss;
+#else
+	return usage.ru_maxrss * 1024L;
+#endif
+#endif
 }
\ No newline at end of file
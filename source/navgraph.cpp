@@ -0,0 +1,551 @@
+/***************************************************************************
+* SimFun
+*  navgraph.cpp -- how the level is connected, and paths through it
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <algorithm>
+#include <math.h>
+#include "level.h"
+#include "navgraph.h"
+#include "player.h"
+
+/* a jump costs this much more than walking the same distance, so paths
+	don't hop along flat ground */
+const real NavGraph::JUMP_COST = 16;
+
+/* sizes in pixels: the player is a circle with a radius of 16, so it
+	stands with its center 16 above the floor, and is 4 tiles high */
+static const int TILE = 8;
+static const real RADIUS = 16;
+/* how far below a jump can land, in tiles */
+static const int JUMP_DROP = 8;
+/* nodes tried per platform when looking for jumps */
+static const int JUMP_TRIES = 5;
+
+NavGraph::NavGraph(MemoryResource *resource):
+	tileWidth(0), tileHeight(0), level(NULL),
+	nodes(Allocator<Node>(resource)), edges(Allocator<Edge>(resource)),
+	standAt(Allocator<int>(resource)), otherAt(Allocator<int>(resource)),
+	cost(Allocator<real>(resource)), via(Allocator<int>(resource)),
+	stamp(Allocator<unsigned int>(resource)), open(Allocator<Open>(resource)),
+	searchStamp(0),
+	cache(Allocator<CacheEntry>(resource)), cachePaths(Allocator<int>(resource)),
+	queries(0), cacheHits(0)
+{
+}
+
+Tile::TileType NavGraph::tileAt(int i, int j) const
+{
+	/* outside the map is solid */
+	if (i < 0 || i >= tileWidth || j < 0 || j >= tileHeight) return Tile::SOLID;
+	return level->mapIndex(i, j);
+}
+
+bool NavGraph::isOpen(int i, int j) const
+{
+	switch (tileAt(i, j))
+	{
+	case Tile::EMPTY:
+	case Tile::LADDER:
+	case Tile::WATER:
+	case Tile::ONE_WAY_U:
+	case Tile::ONE_WAY_D:
+	case Tile::ONE_WAY_L:
+	case Tile::ONE_WAY_R:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool NavGraph::blocks(int i, int j) const
+{
+	/* the player can be partly inside a floor slope (walking on it), but
+		not in a ceiling slope */
+	Tile::TileType t = tileAt(i, j);
+	if (t == Tile::SOLID) return true;
+
+	switch (t)
+	{
+	case Tile::UL_45: case Tile::UR_45:
+	case Tile::UL_26_1: case Tile::UL_26_2: case Tile::UR_26_1: case Tile::UR_26_2:
+	case Tile::UL_63_1: case Tile::UL_63_2: case Tile::UR_63_1: case Tile::UR_63_2:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool NavGraph::blocksAt(real x, real y) const
+{
+	return blocks((int)floor(x / TILE), (int)floor(y / TILE));
+}
+
+bool NavGraph::blocksSide(int i, int j, int di) const
+{
+	/* one way walls face the side they stop the player from */
+	Tile::TileType t = tileAt(i, j);
+	return (t == Tile::ONE_WAY_L && di > 0) || (t == Tile::ONE_WAY_R && di < 0);
+}
+
+bool NavGraph::isFloor(int i, int j) const
+{
+	switch (tileAt(i, j))
+	{
+	case Tile::SOLID:
+	case Tile::ONE_WAY_U:
+	case Tile::DL_45: case Tile::DR_45:
+	case Tile::DL_26_1: case Tile::DL_26_2: case Tile::DR_26_1: case Tile::DR_26_2:
+	case Tile::DL_63_1: case Tile::DL_63_2: case Tile::DR_63_1: case Tile::DR_63_2:
+		return true;
+	case Tile::LADDER:
+		/* the top of a ladder can be walked on */
+		return tileAt(i, j - 1) != Tile::LADDER;
+	default:
+		return false;
+	}
+}
+
+bool NavGraph::isClear(int l, int t, int r, int b) const
+{
+	for (int j = t; j <= b; j++)
+		for (int i = l; i <= r; i++)
+			if (blocks(i, j)) return false;
+	return true;
+}
+
+bool NavGraph::canStand(int i, int j) const
+{
+	/* an open tile over a floor, with room for the player above it. a
+		one way platform can be two tiles high; only stand on the top one */
+	return tileAt(i, j) != Tile::WATER && isOpen(i, j) && !isFloor(i, j) &&
+		isFloor(i, j + 1) && isClear(i - 1, j - 3, i + 1, j);
+}
+
+bool NavGraph::canMove(int i, int j) const
+{
+	/* climbing or swimming: room around the center of a ladder or water
+		tile */
+	Tile::TileType t = tileAt(i, j);
+	return (t == Tile::LADDER || t == Tile::WATER) && isClear(i - 1, j - 2, i + 1, j + 1);
+}
+
+int NavGraph::addNode(int i, int j, NodeType type, const Point &pos)
+{
+	Node n;
+	n.pos = pos;
+	n.type = type;
+	n.i = i;
+	n.j = j;
+	n.firstEdge = n.numEdges = 0;
+	nodes.push_back(n);
+
+	int index = nodes.size() - 1;
+	(type == STAND ? standAt : otherAt)[j * tileWidth + i] = index;
+	return index;
+}
+
+void NavGraph::addEdge(int from, int to, LinkType link, real costScale)
+{
+	Edge e;
+	e.from = from;
+	e.to = to;
+	e.link = link;
+	/* never less than the straight line distance, so that A* can use it
+		as its estimate */
+	e.cost = Point::dist(nodes[from].pos, nodes[to].pos) * costScale;
+	if (link == JUMP) e.cost += JUMP_COST;
+	edges.push_back(e);
+}
+
+void NavGraph::build(const Level &_level, const Physics &physics)
+{
+	level = &_level;
+	tileWidth = level->getTileWidth();
+	tileHeight = level->getTileHeight();
+
+	nodes.clear();
+	edges.clear();
+	standAt.assign(tileWidth * tileHeight, -1);
+	otherAt.assign(tileWidth * tileHeight, -1);
+
+	/* count first, so the arena holds exactly the nodes */
+	int numNodes = 0;
+	for (int j = 0; j < tileHeight; j++)
+		for (int i = 0; i < tileWidth; i++)
+			numNodes += canStand(i, j) + canMove(i, j);
+	nodes.reserve(numNodes);
+	edges.reserve(numNodes * 4);
+
+	for (int j = 0; j < tileHeight; j++)
+		for (int i = 0; i < tileWidth; i++)
+		{
+			Point center(i * TILE + TILE / 2.0f, j * TILE + TILE / 2.0f);
+
+			if (canStand(i, j))
+				addNode(i, j, STAND, Point(center.x, (j + 1) * TILE - RADIUS));
+			if (canMove(i, j))
+				addNode(i, j, tileAt(i, j) == Tile::LADDER ? CLIMB : SWIM, center);
+		}
+
+	Vector arc[JUMP_TICKS];
+	Player::getJumpArc(physics, arc, JUMP_TICKS);
+	real apex = 0;
+	for (int t = 0; t < JUMP_TICKS; t++)
+		apex = std::min(apex, arc[t].v);
+
+	for (unsigned int n = 0; n < nodes.size(); n++)
+	{
+		addWalks(n);
+		if (nodes[n].type == STAND)
+			addJumps(n, arc, apex);
+	}
+
+	/* group the edges by node */
+	std::stable_sort(edges.begin(), edges.end());
+	for (unsigned int e = 0; e < edges.size(); e++)
+	{
+		Node &n = nodes[edges[e].from];
+		if (n.numEdges++ == 0) n.firstEdge = e;
+	}
+
+	/* everything a query needs, so it doesn't allocate. with lazy
+		deletion the open list gets at most one entry per edge */
+	cost.assign(nodes.size(), 0);
+	via.assign(nodes.size(), -1);
+	stamp.assign(nodes.size(), 0);
+	open.reserve(edges.size() + 1);
+
+	CacheEntry empty = { -1, -1, 0 };
+	cache.assign(CACHE_SIZE, empty);
+	cachePaths.assign(CACHE_SIZE * MAX_CACHED_PATH, 0);
+}
+
+void NavGraph::addWalks(int from)
+{
+	const Node n = nodes[from];
+
+	if (n.type == STAND)
+	{
+		for (int di = -1; di <= 1; di += 2)
+		{
+			int i = n.i + di;
+
+			bool stopped = false;
+			for (int j = n.j - 3; j <= n.j; j++)
+				stopped = stopped || blocksSide(i, j, di);
+			if (stopped) continue;
+
+			/* level, or a step (or slope) up or down */
+			int to = -1;
+			for (int dj = 0; dj <= 2 && to < 0; dj++)
+			{
+				int j = n.j + (dj == 2 ? -1 : dj);
+				if (i >= 0 && i < tileWidth && j >= 0 && j < tileHeight)
+					to = standAt[j * tileWidth + i];
+			}
+
+			if (to >= 0)
+			{
+				addEdge(from, to, WALK);
+				continue;
+			}
+
+			/* walking off a ledge: fall to whatever is below */
+			for (int j = n.j; j < tileHeight && !blocks(i, j); j++)
+			{
+				if (i < 0 || i >= tileWidth) break;
+
+				int below = standAt[j * tileWidth + i];
+				if (below < 0 && tileAt(i, j) == Tile::WATER)
+					below = otherAt[j * tileWidth + i];
+
+				if (below >= 0)
+				{
+					addEdge(from, below, FALL);
+					break;
+				}
+			}
+		}
+	}
+	else
+	{
+		/* to the neighbouring ladder or water tiles */
+		static const int di[4] = { -1, 1, 0, 0 }, dj[4] = { 0, 0, -1, 1 };
+		for (int d = 0; d < 4; d++)
+		{
+			int i = n.i + di[d], j = n.j + dj[d];
+			if (i < 0 || i >= tileWidth || j < 0 || j >= tileHeight) continue;
+
+			int to = otherAt[j * tileWidth + i];
+			if (to >= 0 && nodes[to].type == n.type)
+				addEdge(from, to, n.type == CLIMB ? LADDER : WATER, 2);
+		}
+	}
+
+	/* getting on and off: standing places within half a tile or so of the
+		ladder or water tile's center */
+	if (n.type != STAND)
+	{
+		LinkType link = n.type == CLIMB ? LADDER : WATER;
+
+		for (int j = n.j; j <= n.j + 3; j++)
+			for (int i = n.i - 1; i <= n.i + 1; i++)
+			{
+				if (i < 0 || i >= tileWidth || j >= tileHeight) continue;
+
+				int to = standAt[j * tileWidth + i];
+				if (to >= 0 && fabs(nodes[to].pos.y - n.pos.y) <= RADIUS * 0.75f)
+				{
+					addEdge(from, to, link);
+					addEdge(to, from, link);
+				}
+			}
+	}
+}
+
+bool NavGraph::canJump(const Node &from, const Node &to, const Vector *arc, real apex) const
+{
+	real dx = to.pos.x - from.pos.x, dy = to.pos.y - from.pos.y;
+	real adx = (real)fabs(dx), sign = dx < 0 ? -1.0f : 1.0f;
+
+	if (dy < apex) return false;
+
+	/* the tick when the player comes down to the target's height */
+	int land = -1;
+	for (int t = 1; t < JUMP_TICKS && land < 0; t++)
+		if (arc[t].v > arc[t - 1].v && arc[t].v >= dy)
+			land = t;
+
+	if (land < 0 || adx > arc[land].u) return false;
+
+	/* go toward the target at full speed, and stop above it; head, center
+		and feet have to stay out of the walls */
+	for (int t = 0; t <= land; t++)
+	{
+		real x = from.pos.x + sign * std::min(adx, arc[t].u);
+		real y = from.pos.y + (t == land ? dy : arc[t].v);
+
+		if (blocksAt(x, y - RADIUS * 0.75f) || blocksAt(x, y) ||
+			blocksAt(x, y + RADIUS * 0.75f))
+			return false;
+
+		int i = (int)floor(x / TILE), j = (int)floor(y / TILE);
+		if (blocksSide(i, j - 1, (int)sign) || blocksSide(i, j, (int)sign) ||
+			blocksSide(i, j + 1, (int)sign))
+			return false;
+	}
+
+	return true;
+}
+
+void NavGraph::addJumps(int from, const Vector *arc, real apex)
+{
+	const Node n = nodes[from];
+	int reach = (int)(arc[JUMP_TICKS - 1].u / TILE) + 1;
+	int top = n.j + (int)floor(apex / TILE), bottom = n.j + JUMP_DROP;
+
+	/* one jump to each platform (run of standing places in a row) in
+		reach: to the place nearest the start that can be landed on */
+	for (int j = std::max(top, 0); j <= bottom && j < tileHeight; j++)
+	{
+		int l = std::max(n.i - reach, 0), r = std::min(n.i + reach, tileWidth - 1);
+
+		for (int i = l; i <= r; i++)
+		{
+			if (standAt[j * tileWidth + i] < 0) continue;
+
+			int start = i;
+			while (i + 1 <= r && standAt[j * tileWidth + i + 1] >= 0) i++;
+			int end = i;
+
+			/* the platform the jump starts on can be walked */
+			if (j == n.j && start <= n.i && n.i <= end) continue;
+
+			int nearest = clamp(n.i, start, end);
+			for (int k = 0; k < JUMP_TRIES; k++)
+			{
+				/* nearest, then alternately farther on either side */
+				int c = nearest + ((k & 1) ? (k + 1) / 2 : -(k / 2));
+				if (c < start || c > end) continue;
+
+				int to = standAt[j * tileWidth + c];
+				if (canJump(n, nodes[to], arc, apex))
+				{
+					addEdge(from, to, JUMP);
+					break;
+				}
+			}
+		}
+	}
+}
+
+int NavGraph::findNode(const Point &p) const
+{
+	if (nodes.empty()) return -1;
+
+	int i = (int)floor(p.x / TILE), j = (int)floor(p.y / TILE);
+	if (i < 0 || i >= tileWidth || j < 0 || j >= tileHeight) return -1;
+
+	if (otherAt[j * tileWidth + i] >= 0)
+		return otherAt[j * tileWidth + i];
+
+	/* standing places nearby; a bit more below, for a player in the air */
+	int best = -1;
+	real bestDist = 0;
+	int row = (int)floor((p.y + RADIUS) / TILE);
+
+	for (int jj = row - 2; jj <= row + 3; jj++)
+		for (int ii = i - 1; ii <= i + 1; ii++)
+		{
+			if (ii < 0 || ii >= tileWidth || jj < 0 || jj >= tileHeight) continue;
+
+			int n = standAt[jj * tileWidth + ii];
+			if (n < 0) continue;
+
+			real d = Point::dist(p, nodes[n].pos);
+			if (best < 0 || d < bestDist)
+			{
+				best = n;
+				bestDist = d;
+			}
+		}
+
+	return best;
+}
+
+bool NavGraph::search(int start, int goal) const
+{
+	/* a new stamp makes every node unvisited */
+	if (++searchStamp == 0)
+	{
+		std::fill(stamp.begin(), stamp.end(), 0);
+		searchStamp = 1;
+	}
+
+	const Point &target = nodes[goal].pos;
+
+	open.clear();
+	stamp[start] = searchStamp;
+	cost[start] = 0;
+	via[start] = -1;
+
+	Open o = { Point::dist(nodes[start].pos, target), 0, start };
+	open.push_back(o);
+
+	while (!open.empty())
+	{
+		std::pop_heap(open.begin(), open.end());
+		o = open.back();
+		open.pop_back();
+
+		if (o.node == goal) return true;
+		/* a better way to this node was found after this one was added */
+		if (o.cost > cost[o.node]) continue;
+
+		const Node &n = nodes[o.node];
+		for (int e = n.firstEdge; e < n.firstEdge + n.numEdges; e++)
+		{
+			const Edge &edge = edges[e];
+			real c = o.cost + edge.cost;
+
+			if (stamp[edge.to] == searchStamp && cost[edge.to] <= c) continue;
+
+			stamp[edge.to] = searchStamp;
+			cost[edge.to] = c;
+			via[edge.to] = e;
+
+			Open next = { c + Point::dist(nodes[edge.to].pos, target), c, edge.to };
+			open.push_back(next);
+			std::push_heap(open.begin(), open.end());
+		}
+	}
+
+	return false;
+}
+
+bool NavGraph::findPath(const Point &from, const Point &to, Path &path) const
+{
+	path.clear();
+	queries++;
+
+	int start = findNode(from), goal = findNode(to);
+	if (start < 0 || goal < 0) return false;
+
+	CacheEntry &entry = cache[((unsigned int)start * 73856093u ^ (unsigned int)goal * 19349663u) % CACHE_SIZE];
+	int *cached = &cachePaths[((&entry) - &cache[0]) * MAX_CACHED_PATH];
+	int length;
+
+	if (entry.start == start && entry.goal == goal)
+	{
+		cacheHits++;
+		length = entry.length;
+	}
+	else
+	{
+		if (!search(start, goal))
+			length = -1;
+		else
+		{
+			/* count the edges back from the goal, then store them start
+				first */
+			length = 0;
+			for (int n = goal; via[n] >= 0; n = edges[via[n]].from)
+				length++;
+
+			if (length <= MAX_CACHED_PATH)
+			{
+				int k = length;
+				for (int n = goal; via[n] >= 0; n = edges[via[n]].from)
+					cached[--k] = via[n];
+			}
+		}
+
+		if (length <= MAX_CACHED_PATH)
+		{
+			entry.start = start;
+			entry.goal = goal;
+			entry.length = length;
+		}
+	}
+
+	if (length < 0) return false;
+
+	path.resize(length + 1);
+	path[0].pos = nodes[start].pos;
+	path[0].type = nodes[start].type;
+	path[0].link = START;
+
+	/* a path too long for the cache is still in via */
+	int n = goal;
+	for (int k = length; k > 0; k--)
+	{
+		const Edge &e = edges[length <= MAX_CACHED_PATH ? cached[k - 1] : via[n]];
+		path[k].pos = nodes[e.to].pos;
+		path[k].type = nodes[e.to].type;
+		path[k].link = e.link;
+		n = e.from;
+	}
+
+	return true;
+}
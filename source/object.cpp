@@ -24,18 +24,32 @@
 
 #include <algorithm>
 #include "math.h"
+#include "arena.h"
 #include "background.h"
 #include "object.h"
 #include "circle.h"
+#include "simulation.h"
+#include "snapshot.h"
 #include "tilemap.h"
 #include "tilemapentry.h"
+#include "walls.h"
 #include "wallset.h"
 
 Object::Object():
-	scale(1,1), radius(0), normalCount(0)
+	scale(1,1), radius(0), normalCount(0),
+	ignore(Wall::CPList::allocator_type(ignorePool()))
 {
 }
 
+MemoryResource *Object::ignorePool()
+{
+	/* walls are ignored and forgotten again all the time (one way walls,
+		ladder tops), so the list nodes are recycled instead of going back
+		to the heap. objects only live on the main thread */
+	static Arena pool(4096);
+	return &pool;
+}
+
 Object::Object(const Object &o):
 	pos(o.pos), oldPos(o.oldPos), scale(o.scale), size(o.size), radius(o.radius),
 	normal(o.normal), normalCount(o.normalCount), ignore(o.ignore)
@@ -51,23 +65,59 @@ void Object::addNormal(const Vector &n)
 	normalCount++;
 }
 
-void Object::doCollision(Background &bg)
+void Object::save(Snapshot &s) const
+{
+	s.put(pos);
+	s.put(oldPos);
+	s.put(scale);
+	s.put(size);
+	s.put(radius);
+	s.put(normal);
+	s.put(normalCount);
+	s.putWalls(ignore);
+}
+
+void Object::restore(Snapshot &s)
 {
-	WallSet set;
-	const TileMap &tilemap = bg.getTileMap();
+	s.get(pos);
+	s.get(oldPos);
+	s.get(scale);
+	s.get(size);
+	s.get(radius);
+	s.get(normal);
+	s.get(normalCount);
+	s.getWalls(ignore);
+}
 
+Object::TileBounds Object::getTileBounds() const
+{
 	/* get tile bounds of circle */
-	int l = (int)floor((pos.x-radius)/8), r = (int)ceil((pos.x+radius)/8);
-	int t = (int)floor((pos.y-radius)/8), b = (int)ceil((pos.y+radius)/8);
+	TileBounds tb;
+	tb.l = (int)floor((pos.x-radius)/8); tb.r = (int)ceil((pos.x+radius)/8);
+	tb.t = (int)floor((pos.y-radius)/8); tb.b = (int)ceil((pos.y+radius)/8);
+	return tb;
+}
 
+void Object::gatherWalls(const TileMap &tilemap, const TileBounds &tb, WallSet &set)
+{
 	/* add all walls declared for the tiles */
-	for (int j= t; j < b; j++)
-		for (int i= l; i < r; i++)
+	for (int j= tb.t; j < tb.b; j++)
+		for (int i= tb.l; i < tb.r; i++)
 		{
 			const TileMapEntry *tme = tilemap.index(i,j);
 			set.addFromTile(tme);
 		}
+}
 
+void Object::doCollision(Background &bg)
+{
+	WallSet set(&Simulation::get().getFrameArena());
+	gatherWalls(bg.getTileMap(), getTileBounds(), set);
+	collideWalls(bg.getLevel()->getWalls().getBatch(), set);
+}
+
+void Object::collideWalls(const SegmentBatch &batch, const WallSet &set)
+{
 	/* we want to ignore certain walls (tops of ladders when climbing through 
 		them, and one way walls). This loop removes walls from the ignore list
 		if the object doesn't intersect with it */
@@ -88,7 +138,7 @@ void Object::doCollision(Background &bg)
 		not walls enter the equation */
 	bool irregularWalls = false;
 	{
-		WallSet::Iterator i;
+		WallSet::ConstIterator i;
 		for (i = set.begin(); i != set.end(); ++i)
 		{
 			const Edge::EdgeType &type = (**i).wall.type;
@@ -102,13 +152,19 @@ void Object::doCollision(Background &bg)
 
 	/* check all walls found above for collision */
 
-	WallSet::Iterator i;
-	Segment::List collide;
+	WallSet::ConstIterator i;
+	/* same memory as the walls (usually the frame arena) */
+	Segment::List collide(set.get_allocator());
+
+	/* the level's walls are packed by index, four to a group, and walls
+		near each other are mostly in the same group; so the circle is
+		tested against a whole group at once, and the result is kept until
+		the next wall is in another group, or a collision moves the object */
+	int group = -1, hits = 0;
 
 	for (i = set.begin(); i != set.end(); ++i)
 	{
 		const Wall &w = (**i);
-		const Segment &s = w.wall.segment;
 
 		preProcessWall(**i);
 
@@ -121,7 +177,12 @@ void Object::doCollision(Background &bg)
 		if (!irregularWalls)
 		{
 			/* ...or if it doesn't even intersect the circle */
-			if (!s.intersect(Circle(pos, radius)))
+			if (SegmentBatch::getGroup(w.index) != group)
+			{
+				group = SegmentBatch::getGroup(w.index);
+				hits = batch.intersectGroup(group, Circle(pos, radius));
+			}
+			if (!(hits & (1 << SegmentBatch::getLane(w.index))))
 				continue;
 		}
 
@@ -130,7 +191,10 @@ void Object::doCollision(Background &bg)
 			if (irregularWalls)
 				collide.push_back((**i).wall.segment);
 			else
+			{
 				collideWall((**i).wall.segment);
+				group = -1;
+			}
 		}
 	}
 
@@ -282,7 +346,7 @@ void Object::collideWall(const Segment &s)
 		Point p = s.closestPoint(pos);
 
 		Vector d(p, pos);
-		float dlen = d.length();
+		real dlen = d.length();
 
 		d.normalize();
 		/* shunt the object out from the wall */
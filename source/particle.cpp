@@ -26,13 +26,18 @@
 #include "math.h"
 #include "particle.h"
 #include "misc.h"
+#include "physics.h"
 #include "simulation.h"
+#include "snapshot.h"
+#include "spritebatch.h"
 
 const Color Particle::Dust1(128,128,128,48);
 const Color Particle::Dust2(192,192,192,64);
 const Color Particle::Water1(0,119,130,64);
 const Color Particle::Water2(0,0,128,128);
 
+const size_t Particles::POOL_BLOCK_SIZE = 16 * 1024;
+
 Particle::Particle(Particle::ParticleType _type):
 	type(_type)
 {
@@ -46,7 +51,7 @@ Particle::Particle(const Particle &p) :
 {}
 
 Particle Particle::make(ParticleType _type, const Point &pos, const Vector &vel, 
-	const Color &_color, float _scale, int _lifetime)
+	const Color &_color, real _scale, int _lifetime)
 {
 	Particle p(_type);
 	p.setPos(pos);
@@ -60,34 +65,16 @@ Particle Particle::make(ParticleType _type, const Point &pos, const Vector &vel,
 	return p;
 }
 
-void Particle::draw()
+void Particle::draw(SpriteBatch &batch)
 {
-	glPushMatrix();
-		glTranslatef(pos.x,pos.y,0);
-		glScalef(scale.u,scale.v,1);
-		glTranslatef(-size.u,-size.v,0);
-
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glColor4ub(color.r, color.g, color.b, color.a);
-
-		glBegin(GL_QUADS);
-			glVertex2f(0,0);
-			glVertex2f(0,size.v*2);
-			glVertex2f(size.u*2,size.v*2);
-			glVertex2f(size.u*2,0);
-		glEnd();
-
-		glDisable(GL_BLEND);
-	glPopMatrix();
+	/* particles are flat colored, so use the white sprite */
+	float w = size.u * scale.u, h = size.v * scale.v;
+	batch.draw(batch.getAtlas().getWhite(), pos.x - w, pos.y - h, w*2, h*2, color);
 }
 
 void Particle::update()
 {
-	static const float DUST_GRAVITY = -0.1f;
-	static const float DROP_GRAVITY = 0.15f;
-	static const float DRAG = 0.99f;
-	static const float VEL_MAX = 4.5f;
+	const Physics::ParticleMotion &m = Physics::get().particle;
 
 	lifetime--;
 	Vector vel(oldPos, pos);
@@ -96,22 +83,22 @@ void Particle::update()
 	switch (type)
 	{
 	case DUST:
-		gravity = Vector(0, DUST_GRAVITY);
+		gravity = Vector(0, m.dustGravity);
 		break;
 	case DROP_1:
 	case DROP_2:
-		gravity = Vector(0, DROP_GRAVITY);
+		gravity = Vector(0, m.dropGravity);
 		break;
 	}
 
-	if (vel.length() > VEL_MAX)
+	if (vel.length() > m.velMax)
 	{
 		vel.normalize();
-		vel *= VEL_MAX;
+		vel *= m.velMax;
 	}
 
 	oldPos = pos;
-	pos += vel * DRAG + gravity;
+	pos += vel * m.drag + gravity;
 
 	pos.x = clamp(pos.x, size.u, 640-size.u);
 	pos.y = clamp(pos.y, size.v, 480-size.v);
@@ -133,25 +120,22 @@ void Particle::update()
 
 bool Particle::processWall(const Wall &w)
 {
-	static const float NORMAL_SCALE = 2.0f;
-	static const float VECTOR_SCALE = 0.8f;
-	static const float LIFETIME_SCALE = 80;
-	static const int NUM_PARTS = 2;
-
 	lifetime = 0;
 
 	if (type == DROP_1)
 	{
 		Particles &particles = Simulation::get().getParticles();
+		const Physics::ParticleEffects &e = Physics::get().particleEffects;
+		int numParts = (int)e.dropBreak.count;
 
-		for (int i= 0; i < NUM_PARTS; i++)
+		for (int i= 0; i < numParts; i++)
 		{
 			Color color = Color::randomRange(Particle::Water1, Particle::Water2);
 			Vector rnd(frand(), frand());
-			int lifetime = (int)floor(frand()*LIFETIME_SCALE);
+			int lifetime = (int)floor(frand()*e.dropBreak.lifetimeScale);
 
-			rnd += w.wall.segment.normal * NORMAL_SCALE;
-			rnd *= VECTOR_SCALE;
+			rnd += w.wall.segment.normal * e.dropNormalScale;
+			rnd *= e.dropBreak.vectorScale;
 
 			particles.add( Particle::make(Particle::DROP_2, pos, rnd, color, scale.u/2, lifetime) );
 		}
@@ -160,16 +144,32 @@ bool Particle::processWall(const Wall &w)
 	return false;
 }
 
-void Particles::draw()
+void Particle::save(Snapshot &s) const
+{
+	Object::save(s);
+	s.put(type);
+	s.put(color);
+	s.put(lifetime);
+}
+
+void Particle::restore(Snapshot &s)
 {
-	std::list<Particle>::iterator i;
+	Object::restore(s);
+	s.get(type);
+	s.get(color);
+	s.get(lifetime);
+}
+
+void Particles::draw(SpriteBatch &batch)
+{
+	List::iterator i;
 	for (i = particles.begin(); i != particles.end(); ++i)
-		(*i).draw();
+		(*i).draw(batch);
 }
 
 void Particles::update()
 {
-	std::list<Particle>::iterator i;
+	List::iterator i;
 	for (i = particles.begin(); i != particles.end();)
 	{
 		(*i).update();
@@ -182,23 +182,46 @@ void Particles::update()
 	}
 }
 
-void Particles::skidDust(const Point &p, const Vector &v)
+void Particles::save(Snapshot &s) const
+{
+	s.put((int)particles.size());
+
+	List::const_iterator i;
+	for (i = particles.begin(); i != particles.end(); ++i)
+		(*i).save(s);
+}
+
+void Particles::restore(Snapshot &s)
 {
-	/* I just tweaked these constants until I thought they looked good. */
-	static const float NUM_PARTICLE_SCALE = 4.0f;
-	static const float VECTOR_SCALE = 0.5f;
-	static const float LIFETIME_SCALE = 15;
+	int n;
+	s.get(n);
 
-	int numParts = (int)floor(v.length()*NUM_PARTICLE_SCALE);
+	/* restore over the particles that are already there, so restoring
+		over and over again doesn't allocate */
+	List::iterator i = particles.begin();
+	for (int k = 0; k < n; k++, ++i)
+	{
+		if (i == particles.end())
+			i = particles.insert(i, Particle(Particle::DUST));
+		(*i).restore(s);
+	}
+
+	particles.erase(i, particles.end());
+}
+
+void Particles::skidDust(const Point &p, const Vector &v)
+{
+	const Physics::Burst &b = Physics::get().particleEffects.skidDust;
+	int numParts = (int)floor(v.length()*b.count);
 
 	for (int i= 0; i < numParts; i++)
 	{
 		Color color = Color::randomRange(Particle::Dust1, Particle::Dust2);
 		Vector rnd(frand()*2-1, frand()*2-1);
-		int lifetime = (int)floor(frand()*LIFETIME_SCALE);
+		int lifetime = (int)floor(frand()*b.lifetimeScale);
 
 		rnd += v;
-		rnd *= VECTOR_SCALE;
+		rnd *= b.vectorScale;
 
 		particles.push_back( Particle::make(Particle::DUST, p, rnd, color, frand(), lifetime) );
 	}
@@ -206,21 +229,17 @@ void Particles::skidDust(const Point &p, const Vector &v)
 
 void Particles::waterSplash(const Point &p, const Vector &v)
 {
-	/* I just tweaked these constants until I thought they looked good. */
-	static const float NUM_PARTICLE_SCALE = 2.5f;
-	static const float VECTOR_SCALE = 0.8f;
-	static const float LIFETIME_SCALE = 80;
-
-	int numParts = (int)floor(v.length()*NUM_PARTICLE_SCALE);
+	const Physics::Burst &b = Physics::get().particleEffects.waterSplash;
+	int numParts = (int)floor(v.length()*b.count);
 
 	for (int i= 0; i < numParts; i++)
 	{
 		Color color = Color::randomRange(Particle::Water1, Particle::Water2);
 		Vector rnd(frand(), frand());
-		int lifetime = (int)floor(frand()*LIFETIME_SCALE);
+		int lifetime = (int)floor(frand()*b.lifetimeScale);
 
 		rnd += v;
-		rnd *= VECTOR_SCALE;
+		rnd *= b.vectorScale;
 
 		particles.push_back( Particle::make(Particle::DROP_1, p, rnd, color, frand(), lifetime) );
 	}
@@ -0,0 +1,190 @@
+/***************************************************************************
+* SimFun
+*  physics.cpp -- the tunable numbers behind movement
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <stdio.h>
+#include <string.h>
+#include "physics.h"
+#include "misc.h"
+
+static const int MAX_FIELDS = 64;
+static const int MAX_LINE = 256;
+
+Physics Physics::current;
+
+Physics::Physics()
+{
+	player.drag = 0.99f;
+	player.gravity = 0.15f;
+	player.airborneGravity = 0.35f;
+	player.jumpGravity = 0.12f;
+	player.accel = 0.20f;
+	player.airAccel = 0.10f;
+	player.skidAccel = 0.08f;
+	player.skidMultiplier = 6.0f;
+	player.skidMaxAngle = 20.0f;
+	player.skidFriction = 0.90f;
+	player.velMaxX = 3.0f;
+	player.velMaxY = 6.0f;
+	player.velMin = 1e-3f;
+	player.maxRot = 5.0f;
+	player.maxJumpTime = 20;
+	player.jumpMaxAirborneTime = 6;
+
+	particle.dustGravity = -0.1f;
+	particle.dropGravity = 0.15f;
+	particle.drag = 0.99f;
+	particle.velMax = 4.5f;
+
+	playerActions.jumpVelScale = 0.3f;
+	playerActions.jumpThrust = 4.5f;
+	playerActions.jumpYBias = 1.2f;
+	playerActions.airborneJumpThrust = 5.4f;
+	playerActions.climbFrictionX = 0.3f;
+	playerActions.climbFrictionY = 0.5f;
+	playerActions.waterGravity = -0.14f;
+	playerActions.waterAccel = 0.10f;
+	playerActions.waterThrust = 3.0f;
+	playerActions.dripGravity = 2.0f;
+	playerActions.ticksPerDrip = 30;
+	playerActions.wetTime = 60*20;
+
+	/* I just tweaked these constants until I thought they looked good. */
+	particleEffects.skidDust.count = 4.0f;
+	particleEffects.skidDust.vectorScale = 0.5f;
+	particleEffects.skidDust.lifetimeScale = 15;
+	particleEffects.waterSplash.count = 2.5f;
+	particleEffects.waterSplash.vectorScale = 0.8f;
+	particleEffects.waterSplash.lifetimeScale = 80;
+	particleEffects.dropBreak.count = 2;
+	particleEffects.dropBreak.vectorScale = 0.8f;
+	particleEffects.dropBreak.lifetimeScale = 80;
+	particleEffects.dropNormalScale = 2.0f;
+}
+
+int Physics::getFields(Field *fields)
+{
+	/* the names in the file */
+	Field list[] =
+	{
+		{ "player.drag", &player.drag, NULL },
+		{ "player.gravity", &player.gravity, NULL },
+		{ "player.airborne_gravity", &player.airborneGravity, NULL },
+		{ "player.jump_gravity", &player.jumpGravity, NULL },
+		{ "player.accel", &player.accel, NULL },
+		{ "player.air_accel", &player.airAccel, NULL },
+		{ "player.skid_accel", &player.skidAccel, NULL },
+		{ "player.skid_multiplier", &player.skidMultiplier, NULL },
+		{ "player.skid_max_angle", &player.skidMaxAngle, NULL },
+		{ "player.skid_friction", &player.skidFriction, NULL },
+		{ "player.vel_max_x", &player.velMaxX, NULL },
+		{ "player.vel_max_y", &player.velMaxY, NULL },
+		{ "player.vel_min", &player.velMin, NULL },
+		{ "player.max_rot", &player.maxRot, NULL },
+		{ "player.max_jump_time", NULL, &player.maxJumpTime },
+		{ "player.jump_max_airborne_time", NULL, &player.jumpMaxAirborneTime },
+
+		{ "player.jump_vel_scale", &playerActions.jumpVelScale, NULL },
+		{ "player.jump_thrust", &playerActions.jumpThrust, NULL },
+		{ "player.jump_y_bias", &playerActions.jumpYBias, NULL },
+		{ "player.airborne_jump_thrust", &playerActions.airborneJumpThrust, NULL },
+		{ "player.climb_friction_x", &playerActions.climbFrictionX, NULL },
+		{ "player.climb_friction_y", &playerActions.climbFrictionY, NULL },
+		{ "player.water_gravity", &playerActions.waterGravity, NULL },
+		{ "player.water_accel", &playerActions.waterAccel, NULL },
+		{ "player.water_thrust", &playerActions.waterThrust, NULL },
+		{ "player.drip_gravity", &playerActions.dripGravity, NULL },
+		{ "player.ticks_per_drip", NULL, &playerActions.ticksPerDrip },
+		{ "player.wet_time", NULL, &playerActions.wetTime },
+
+		{ "particle.dust_gravity", &particle.dustGravity, NULL },
+		{ "particle.drop_gravity", &particle.dropGravity, NULL },
+		{ "particle.drag", &particle.drag, NULL },
+		{ "particle.vel_max", &particle.velMax, NULL },
+
+		{ "skid_dust.count", &particleEffects.skidDust.count, NULL },
+		{ "skid_dust.vector_scale", &particleEffects.skidDust.vectorScale, NULL },
+		{ "skid_dust.lifetime_scale", &particleEffects.skidDust.lifetimeScale, NULL },
+		{ "water_splash.count", &particleEffects.waterSplash.count, NULL },
+		{ "water_splash.vector_scale", &particleEffects.waterSplash.vectorScale, NULL },
+		{ "water_splash.lifetime_scale", &particleEffects.waterSplash.lifetimeScale, NULL },
+		{ "drop_break.count", &particleEffects.dropBreak.count, NULL },
+		{ "drop_break.vector_scale", &particleEffects.dropBreak.vectorScale, NULL },
+		{ "drop_break.lifetime_scale", &particleEffects.dropBreak.lifetimeScale, NULL },
+		{ "drop_break.normal_scale", &particleEffects.dropNormalScale, NULL },
+	};
+
+	int n = sizeof(list) / sizeof(list[0]);
+	memcpy(fields, list, sizeof(list));
+	return n;
+}
+
+bool Physics::load(const char *file)
+{
+	FILE *f;
+	char line[MAX_LINE], name[MAX_LINE];
+	float value;
+
+	if ((f = fopen(file, "r")) == NULL)
+	{
+		ErrorBox("Unable to load %s\n", file);
+		return false;
+	}
+
+	/* read into a copy, so a mistake halfway through a file that's being
+		edited doesn't leave half of it applied */
+	Physics p = current;
+	Field fields[MAX_FIELDS];
+	int numFields = p.getFields(fields);
+
+	for (int lineNum = 1; fgets(line, sizeof(line), f); lineNum++)
+	{
+		char *comment = strchr(line, '#');
+		if (comment) *comment = 0;
+
+		int read = sscanf(line, "%s %f", name, &value);
+		if (read <= 0) continue;
+
+		int k;
+		for (k = 0; k < numFields; k++)
+			if (strcmp(fields[k].name, name) == 0) break;
+
+		if (read != 2 || k == numFields)
+		{
+			ErrorBox(read != 2 ? "%s:%d: missing value for %s\n" :
+				"%s:%d: unknown parameter %s\n", file, lineNum, name);
+			fclose(f);
+			return false;
+		}
+
+		if (fields[k].f)
+			*fields[k].f = value;
+		else
+			*fields[k].i = (int)value;
+	}
+
+	fclose(f);
+	current = p;
+	return true;
+}
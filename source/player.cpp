@@ -27,44 +27,22 @@
 #include <set>
 #include "SDL.h"
 #include "SDL_opengl.h"
+#include "atlas.h"
 #include "player.h"
 #include "global.h"
 #include "misc.h"
 #include "segment.h"
 #include "simulation.h"
+#include "snapshot.h"
+#include "spritebatch.h"
 #include "tilemap.h"
+#include "walls.h"
 #include "wallset.h"
 
-const float Player::DRAG = 0.99f;
-const float Player::GRAVITY = 0.15f;
-const float Player::AIRBORNE_GRAVITY = 0.35f;
-const float Player::WATER_GRAVITY = -0.14f;
-const float Player::JUMP_GRAVITY = 0.12f;
-const float Player::DRIP_GRAVITY = 2.0f;
-const float Player::ACCEL = 0.20f;
-const float Player::AIR_ACCEL = 0.10f;
-const float Player::SKID_ACCEL = 0.08f;
-const float Player::WATER_ACCEL = 0.10f;
-const float Player::WATER_THRUST = 3.0f;
-const float Player::SKID_MULTIPLIER = 6.0f;
-const float Player::SKID_MAX_ANGLE = 20.0f;
-const float Player::SKID_FRICTION = 0.90f;
-const float Player::CLIMB_FRICTION_X = 0.3f;
-const float Player::CLIMB_FRICTION_Y = 0.5f;
-const float Player::JUMP_VEL_SCALE = 0.3f;
-const float Player::JUMP_THRUST = 4.5f;
-const float Player::JUMP_Y_BIAS = 1.2f;
-const float Player::AIRBORNE_JUMP_THRUST = 5.4f;
-const float Player::VEL_MAX_X = 3.0f;
-const float Player::VEL_MAX_Y = 6.0f;
-const float Player::VEL_MIN = 1e-3f;
-const float Player::MAX_ROT = 5.0f;
-const int Player::MAX_JUMP_TIME = 20;
-const int Player::TICKS_PER_DRIP = 30;
-const int Player::JUMP_MAX_AIRBORNE_TIME = 6;
-const int Player::WET_TIME = 60*20;
+typedef std::set<const Region *, std::less<const Region *>, Allocator<const Region *> > RegionSet;
 
 Player::Player():
+	sprite(0),
 	angle(0), skidAngle(0), 
 	flags(0),
 	jumpTime(0), airborneTime(0), wetTime(0),
@@ -74,35 +52,72 @@ Player::Player():
 	radius = 16;
 }
 
-void Player::draw()
+void Player::draw(SpriteBatch &batch)
 {
-	glPushMatrix();
-		glTranslatef(pos.x,pos.y,0);
-		glRotatef(angle,0,0,1);
-		glScalef(scale.u,scale.v,1);
-		glTranslatef(-size.u,-size.v,0);
-
-		glEnable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
-
-		glBegin(GL_QUADS);
-			glTexCoord2f(0, 0);			glVertex2f(0,0);
-			glTexCoord2f(0, 1.0f);		glVertex2f(0,size.v*2);
-			glTexCoord2f(0.75f, 1.0f);	glVertex2f(size.u*2,size.v*2);
-			glTexCoord2f(0.75f, 0);		glVertex2f(size.u*2,0);
-		glEnd();
-
-		glDisable(GL_TEXTURE_2D);
-	glPopMatrix();
+	/* same transform as the old glTranslate/glRotate/glScale, done here so
+		the quad can go in the batch */
+	float rad = angle * 3.1415926f / 180.0f;
+	Vector x(cos(rad), sin(rad)), y = -Vector::perp(x);
+	Vector hu = x * (size.u * scale.u), hv = y * (size.v * scale.v);
+
+	Point corners[4] =
+	{
+		pos - hu - hv,
+		pos - hu + hv,
+		pos + hu + hv,
+		pos + hu - hv
+	};
+
+	batch.draw(batch.getAtlas().getSprite(sprite), corners);
+}
+
+void Player::save(Snapshot &s) const
+{
+	Object::save(s);
+	s.put(sprite);
+	s.put(angle);
+	s.put(skidAngle);
+	s.put(flags);
+	s.put(jumpTime);
+	s.put(airborneTime);
+	s.put(wetTime);
+	s.put(input);
+	s.put(oldInput);
+	s.put(newInput);
+}
+
+void Player::restore(Snapshot &s)
+{
+	Object::restore(s);
+	s.get(sprite);
+	s.get(angle);
+	s.get(skidAngle);
+	s.get(flags);
+	s.get(jumpTime);
+	s.get(airborneTime);
+	s.get(wetTime);
+	s.get(input);
+	s.get(oldInput);
+	s.get(newInput);
 }
 
 void Player::update()
 {
+	move();
+	doCollision(Simulation::get().getBackground());
+	settle();
+}
+
+void Player::move()
+{
+	/* m is one cache line; a is only read when something happens */
+	const Physics::PlayerMotion &m = Physics::get().player;
+	const Physics::PlayerActions &a = Physics::get().playerActions;
+
 	/* process input */
 	Vector acc;
 	Vector vel(oldPos, pos);
-	Vector gravity(0, GRAVITY);
+	Vector gravity(0, m.gravity);
 
 	if ((input & LEFT) == LEFT) { acc.u -= 1; }
 	if ((input & RIGHT) == RIGHT) { acc.u += 1; }
@@ -130,22 +145,22 @@ void Player::update()
 	{
 		if (newInput & DOWN)
 		{
-			acc.v += WATER_THRUST;
+			acc.v += a.waterThrust;
 		}
-		if (underWater()) gravity = Vector(0, WATER_GRAVITY);
+		if (underWater()) gravity = Vector(0, a.waterGravity);
 
-		acc.u *= WATER_ACCEL;
+		acc.u *= a.waterAccel;
 	}
 	else if (isClimbing())
 	{
 		gravity = Vector(0,0);
-		vel.u *= CLIMB_FRICTION_X;
-		vel.v *= CLIMB_FRICTION_Y;
+		vel.u *= a.climbFrictionX;
+		vel.v *= a.climbFrictionY;
 	}
 	else if (isAirborne())
 	{
-		acc.u *= AIR_ACCEL;
-		gravity = Vector(0, AIRBORNE_GRAVITY);
+		acc.u *= m.airAccel;
+		gravity = Vector(0, m.airborneGravity);
 		airborneTime++;
 	}
 	else
@@ -154,11 +169,11 @@ void Player::update()
 		if (acc.u * vel.u <= 0 && vel.u != 0)
 		{
 			setFlag(IS_SKIDDING);
-			skidAngle = clamp(SKID_MULTIPLIER * -vel.u, -SKID_MAX_ANGLE, SKID_MAX_ANGLE);
-			acc.u *= SKID_ACCEL;
-			vel.u *= SKID_FRICTION;
+			skidAngle = clamp(m.skidMultiplier * -vel.u, -m.skidMaxAngle, m.skidMaxAngle);
+			acc.u *= m.skidAccel;
+			vel.u *= m.skidFriction;
 
-			float rnd = frand()*2-1;
+			real rnd = frand()*2-1;
 			Vector r = Vector::perp(normal) * rnd;
 			Point p = pos - normal * radius - r * size.u;
 
@@ -168,19 +183,19 @@ void Player::update()
 		{
 			/* this "else" is for plain old ground moving */
 			skidAngle = 0;
-			acc.u *= ACCEL;
+			acc.u *= m.accel;
 		}
 	}
 
 	/* drip if you're wet! */
 	if (isWet() && !(inWater() || underWater()))
 	{
-		if ((wetTime % TICKS_PER_DRIP) == 0)
+		if ((wetTime % a.ticksPerDrip) == 0)
 		{
-			float rx = frand()*2-1, ry = frand()*2-1;
+			real rx = frand()*2-1, ry = frand()*2-1;
 			Vector up = normal, right = Vector::perp(normal);
 			Point p = pos + up * ry * size.v + right * rx * size.u;
-			Simulation::get().getParticles().waterSplash(p, Vector(0,DRIP_GRAVITY));
+			Simulation::get().getParticles().waterSplash(p, Vector(0,a.dripGravity));
 		}
 		wetTime--;
 	}
@@ -196,16 +211,16 @@ void Player::update()
 			if (isClimbing() || inWater() || inJumpBias())
 			{
 				/* you're jumping! */
-				vel.v *= JUMP_VEL_SCALE;
+				vel.v *= a.jumpVelScale;
 
 				if (isAirborne())
 				{
-					acc.v = -AIRBORNE_JUMP_THRUST;
+					acc.v = -a.airborneJumpThrust;
 				}
 				else
 				{
-					acc.u += JUMP_THRUST * normal.u;
-					acc.v = JUMP_THRUST * JUMP_Y_BIAS * normal.v;
+					acc.u += a.jumpThrust * normal.u;
+					acc.v = a.jumpThrust * a.jumpYBias * normal.v;
 				}
 
 				setFlag(IS_JUMPING);
@@ -217,38 +232,40 @@ void Player::update()
 	}
 	else if (isJumping())
 	{
-		gravity = Vector(0, JUMP_GRAVITY);
+		gravity = Vector(0, m.jumpGravity);
 		jumpTime++;
 
 		/* stop jumping if you release the jump button, you've already been jumping
 			the maximum jump time, or if you're not airborne anymore (i.e. you hit the ground) */
-		if (!((input & JUMP) && jumpTime <= MAX_JUMP_TIME && isAirborne()))
+		if (!((input & JUMP) && jumpTime <= m.maxJumpTime && isAirborne()))
 			resetFlag(IS_JUMPING);
 	}
 
-	vel.u = clamp(vel.u, -VEL_MAX_X, VEL_MAX_X);
-	/* this VEL_MIN business is to keep from having ridiculously 
+	vel.u = clamp(vel.u, -m.velMaxX, m.velMaxX);
+	/* this velMin business is to keep from having ridiculously 
 		small horizontal velocities from sliding */
-	if (fabs(vel.u) < VEL_MIN) vel.u = 0;
-	vel.v = clamp(vel.v, -VEL_MAX_Y, VEL_MAX_Y);
+	if (fabs(vel.u) < m.velMin) vel.u = 0;
+	vel.v = clamp(vel.v, -m.velMaxY, m.velMaxY);
 
 	oldPos = pos;
 	vel += acc;
-	pos += vel * DRAG + gravity;
+	pos += vel * m.drag + gravity;
 
 	pos.x = clamp(pos.x, size.u, 640-size.u);
 	pos.y = clamp(pos.y, size.v, 480-size.v);
-	
-	/* do collision */
-	doCollision(Simulation::get().getBackground());
+}
+
+void Player::settle()
+{
+	const Physics::PlayerMotion &m = Physics::get().player;
 
 	/* rotate player */
 	angle *= 0.90f;
 
 	if (normalCount > 0)
 	{
-		float toAngle = (float)(atan2(normal.u, -normal.v) * 180.0f / 3.1415926f) + skidAngle;
-		angle += clamp(toAngle - angle, -MAX_ROT, MAX_ROT);
+		real toAngle = (real)(atan2(normal.u, -normal.v) * 180.0f / 3.1415926f) + skidAngle;
+		angle += clamp(toAngle - angle, -m.maxRot, m.maxRot);
 
 		normalCount = 0;
 
@@ -262,14 +279,21 @@ void Player::update()
 }
 
 void Player::doCollision(Background &bg)
+{
+	WallSet set(&Simulation::get().getFrameArena());
+	gatherWalls(bg.getTileMap(), getTileBounds(), set);
+	doCollision(bg, set);
+}
+
+void Player::doCollision(Background &bg, const WallSet &walls)
 {
 	/* clear flags each frame */
 	clearFlags(ON_LADDER | IN_WATER | UNDER_WATER);
 
-	Object::doCollision(bg);
+	collideWalls(bg.getLevel()->getWalls().getBatch(), walls);
 
 	/* do region collision */
-	std::set<const Region *> set;
+	RegionSet set(std::less<const Region *>(), walls.get_allocator());
 	const TileMap &tilemap = bg.getTileMap();
 
 	/* find the regions we have to check */
@@ -290,7 +314,7 @@ void Player::doCollision(Background &bg)
 		}
 
 	/* check the regions... pretty simple stuff */
-	std::set<const Region *>::iterator i;
+	RegionSet::iterator i;
 	for (i = set.begin(); i != set.end(); ++i)
 	{
 		const Region &r = **i;
@@ -306,7 +330,7 @@ void Player::doCollision(Background &bg)
 			if (r.contains(pos))
 			{
 				setFlag(UNDER_WATER);
-				wetTime = WET_TIME;
+				wetTime = Physics::get().playerActions.wetTime;
 			}
 			break;
 		}
@@ -362,7 +386,7 @@ bool Player::processWall(const Wall &w)
 	{
 		/* kinda convoluted code to spray water nicely */
 		Vector vel(oldPos, pos);
-		float proj = (float)fabs(Vector::dot(vel, s.normal));
+		real proj = (real)fabs(Vector::dot(vel, s.normal));
 
 		/* we don't want to splash water unless were moving fast enough, with
 			respect to the direction of the segment normal */
@@ -370,7 +394,7 @@ bool Player::processWall(const Wall &w)
 		{
 			Point p = s.closestPoint(pos);
 			Vector v= s.normal * proj;
-			float rnd = frand()*2-1;
+			real rnd = frand()*2-1;
 			Vector r = Vector::perp(s.normal) * rnd;
 			/* r is a random vector to add so the water particles don't all 
 				originate from p */
@@ -384,30 +408,56 @@ bool Player::processWall(const Wall &w)
 	return Object::processWall(w);
 }
 
-void Player::getInput(Uint8 *keys)
+void Player::getJumpArc(const Physics &physics, Vector *arc, int ticks)
 {
-	oldInput = input;
-	input = 0;
+	/* the same steps as move(), with the branches the jump takes */
+	const Physics::PlayerMotion &m = physics.player;
+	const Physics::PlayerActions &a = physics.playerActions;
+	Vector pos, vel(m.velMaxX, 0);
+	int jumpTime = 0;
+
+	for (int t = 0; t < ticks; t++)
+	{
+		Vector acc(1, 0), gravity;
+
+		if (t == 0)
+		{
+			/* on the ground, pressing jump */
+			acc.u *= m.accel;
+			gravity = Vector(0, m.gravity);
+			vel.v *= a.jumpVelScale;
+			acc.v = -a.jumpThrust * a.jumpYBias;
+		}
+		else
+		{
+			acc.u *= m.airAccel;
+			gravity = Vector(0, jumpTime <= m.maxJumpTime ? m.jumpGravity : m.airborneGravity);
+			jumpTime++;
+		}
+
+		vel.u = clamp(vel.u, -m.velMaxX, m.velMaxX);
+		vel.v = clamp(vel.v, -m.velMaxY, m.velMaxY);
 
-	if (keys[SDLK_UP]) input |= UP;
-	if (keys[SDLK_DOWN]) input |= DOWN;
-	if (keys[SDLK_LEFT]) input |= LEFT;
-	if (keys[SDLK_RIGHT]) input |= RIGHT;
-	if (keys[SDLK_SPACE]) input |= JUMP;
+		vel += acc;
+		Vector step = vel * m.drag + gravity;
+		pos += step;
+		vel = step;
+
+		arc[t] = pos;
+	}
+}
+
+void Player::setInput(int buttons)
+{
+	oldInput = input;
+	input = buttons;
 
 	/* newInput is the buttons that have been pressed this frame, but not
 		last frame */
 	newInput = (oldInput ^ input) & input;
 }
 
-void Player::loadImage(const char *file)
+void Player::loadImage(Atlas &atlas, const char *file)
 {
-	if ((image = loadBMP(file)) == NULL) exit(1);
-	if ((image = makeTexture(image)) == NULL) exit(1);
-
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image->w, image->h, 0, GL_RGB, GL_UNSIGNED_BYTE, image->pixels);
+	if ((sprite = atlas.add(file)) < 0) exit(1);
 }
@@ -48,9 +48,9 @@ Vector operator -(const Point &a, const Point &b)
 	return Vector(b,a);
 }
 
-float Point::dist(const Point &a, const Point &b)
+real Point::dist(const Point &a, const Point &b)
 {
 	/* simple pythagorean distance */
-	float dx = a.x - b.x, dy = a.y - b.y;
-	return (float)sqrt(dx*dx + dy*dy);
+	real dx = a.x - b.x, dy = a.y - b.y;
+	return (real)sqrt(dx*dx + dy*dy);
 }
\ No newline at end of file
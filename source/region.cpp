@@ -41,7 +41,7 @@ bool Region::contains(const Point &p) const
 		if ( (p.y >= s.p0.y && p.y < s.p1.y) ||
 			(p.y >= s.p1.y && p.y < s.p0.y) )
 		{
-			float x = (p.y - s.p0.y) * (s.p1.x - s.p0.x) / (s.p1.y - s.p0.y) + s.p0.x;
+			real x = (p.y - s.p0.y) * (s.p1.x - s.p0.x) / (s.p1.y - s.p0.y) + s.p0.x;
 			if (p.x > x) 
 				retVal = !retVal;
 		}
@@ -49,16 +49,20 @@ bool Region::contains(const Point &p) const
 	return retVal;
 }
 
-Region::IntersectType Region::intersect(const Circle &c) const
+void Region::buildBatch()
 {
-	WallSet::ConstIterator i;
-	IntersectType retVal = (contains(c.center) ? CONTAIN : DISJOINT);
+	batch.clear();
+	batch.reserve(walls.size());
 
+	WallSet::ConstIterator i;
 	for (i = walls.begin(); i != walls.end(); ++i)
-	{
-		const Segment &s = (**i).wall.segment;
-		if (s.intersect(c))
-			return INTERSECT;
-	}
-	return retVal;
+		batch.add((**i).wall.segment);
+}
+
+Region::IntersectType Region::intersect(const Circle &c) const
+{
+	if (batch.intersectAny(c))
+		return INTERSECT;
+
+	return contains(c.center) ? CONTAIN : DISJOINT;
 }
@@ -0,0 +1,66 @@
+/***************************************************************************
+* SimFun
+*  renderer.cpp -- picks the GL backend
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <string.h>
+#include <vector>
+#include "gl3renderer.h"
+#include "legacyrenderer.h"
+#include "misc.h"
+
+Renderer *Renderer::create(Backend backend, int width, int height)
+{
+	if (backend != LEGACY)
+	{
+		GL3Renderer *r = new GL3Renderer(width, height);
+		if (r->init()) return r;
+		delete r;
+
+		if (backend == GL3)
+		{
+			ErrorBox("Couldn't initialize the GL 3.3 renderer.\n");
+			return NULL;
+		}
+	}
+
+	return new LegacyRenderer(width, height);
+}
+
+void Renderer::readPixels(Uint8 *rgba, int width, int height)
+{
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadBuffer(GL_BACK);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+
+	/* GL's rows are bottom up */
+	int pitch = width * 4;
+	std::vector<Uint8> temp(pitch);
+	for (int j = 0; j < height / 2; j++)
+	{
+		Uint8 *top = rgba + j * pitch, *bottom = rgba + (height - 1 - j) * pitch;
+		memcpy(&temp[0], top, pitch);
+		memcpy(top, bottom, pitch);
+		memcpy(bottom, &temp[0], pitch);
+	}
+}
@@ -0,0 +1,181 @@
+/***************************************************************************
+* SimFun
+*  rollback.cpp -- predicts other players, and corrects when they disagree
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <string.h>
+#include "rollback.h"
+#include "simulation.h"
+
+void LoopbackTransport::send(const InputMessage &m)
+{
+	InputMessage echo = m;
+	echo.player = remotePlayer;
+	queue.push_back(echo);
+
+	/* one message is sent per tick, so that's the clock */
+	now = m.tick;
+}
+
+bool LoopbackTransport::receive(InputMessage &m)
+{
+	if (queue.empty() || queue.front().tick + latency > now) return false;
+
+	m = queue.front();
+	queue.pop_front();
+	return true;
+}
+
+Rollback::Rollback():
+	transport(NULL), numPlayers(0), localPlayer(0), tick(0),
+	rollbacks(0), resimulated(0), stalls(0)
+{
+}
+
+void Rollback::start(int _numPlayers, int _localPlayer, Transport *_transport)
+{
+	numPlayers = _numPlayers < MAX_PLAYERS ? _numPlayers : MAX_PLAYERS;
+	localPlayer = _localPlayer;
+	transport = _transport;
+
+	tick = 0;
+	rollbacks = resimulated = stalls = 0;
+	early.clear();
+
+	for (int p = 0; p < MAX_PLAYERS; p++)
+	{
+		lastInput[p] = 0;
+		lastTick[p] = -1;
+	}
+}
+
+void Rollback::receive(int &rollbackTo)
+{
+	InputMessage m;
+
+	while (transport->receive(m))
+	{
+		int p = m.player;
+		if (p < 0 || p >= numPlayers || p == localPlayer) continue;
+
+		lastInput[p] = m.buttons;
+		lastTick[p] = m.tick;
+
+		if (m.tick >= tick)
+		{
+			/* the other player is ahead of us; use it when we get there */
+			early.push_back(m);
+			continue;
+		}
+
+		/* can't be older than the ring buffer, advance() waits for that */
+		Frame &f = frame(m.tick);
+		f.confirmed |= 1 << p;
+		if (f.inputs[p] != m.buttons)
+		{
+			f.inputs[p] = m.buttons;
+			if (m.tick < rollbackTo) rollbackTo = m.tick;
+		}
+	}
+}
+
+void Rollback::predict(Frame &f)
+{
+	/* guess that the buttons haven't changed since the last input we got */
+	for (int p = 0; p < numPlayers; p++)
+		if ((f.confirmed & (1 << p)) == 0)
+			f.inputs[p] = lastInput[p];
+}
+
+void Rollback::simulate(int t, bool save)
+{
+	Simulation &sim = Simulation::get();
+	Frame &f = frame(t);
+
+	if (save) sim.saveState(f.state);
+	sim.step(f.inputs, numPlayers);
+}
+
+bool Rollback::advance(int buttons)
+{
+	int rollbackTo = tick;
+	receive(rollbackTo);
+
+	if (rollbackTo < tick)
+	{
+		/* go back to the first wrong tick, and run everything again with
+			the real inputs (and new predictions for the rest) */
+		if (!Simulation::get().restoreState(frame(rollbackTo).state))
+		{
+			/* the level changed under us, nothing to go back to */
+			stop();
+			return false;
+		}
+
+		rollbacks++;
+		for (int t = rollbackTo; t < tick; t++)
+		{
+			predict(frame(t));
+			simulate(t, t != rollbackTo);
+			resimulated++;
+		}
+	}
+
+	/* the oldest tick that might still be rolled back to has to stay in
+		the buffer */
+	for (int p = 0; p < numPlayers; p++)
+		if (p != localPlayer && tick - lastTick[p] >= MAX_TICKS - 1)
+		{
+			stalls++;
+			return false;
+		}
+
+	Frame &f = frame(tick);
+	f.confirmed = 1 << localPlayer;
+	f.inputs[localPlayer] = buttons;
+
+	std::vector<InputMessage>::iterator i;
+	for (i = early.begin(); i != early.end(); )
+	{
+		if ((*i).tick == tick)
+		{
+			f.confirmed |= 1 << (*i).player;
+			f.inputs[(*i).player] = (*i).buttons;
+			i = early.erase(i);
+		}
+		else
+			++i;
+	}
+	predict(f);
+
+	InputMessage m;
+	m.player = localPlayer;
+	m.tick = tick;
+	m.buttons = buttons;
+	transport->send(m);
+
+	simulate(tick, true);
+	tick++;
+
+	return true;
+}
@@ -42,7 +42,7 @@
 */
 /********************************************************/
 
-float Segment::dist(const Point &p) const
+real Segment::dist(const Point &p) const
 {
 	return Vector(closestPoint(p),p).length();
 }
@@ -52,20 +52,22 @@ Point Segment::closestPoint(const Point &p) const
 	Vector v = p1 - p0;
 	Vector w = p - p0;
 
-	float c1 = Vector::dot(w,v);
+	real c1 = Vector::dot(w,v);
 	if (c1 <= 0) return p0;
 
-	float c2 = Vector::dot(v,v);
+	real c2 = Vector::dot(v,v);
 	if (c2 <= c1) return p1;
 
-	float b = c1 / c2;
+	real b = c1 / c2;
 
 	return (p0 + b * v);
 }
 
 bool Segment::intersect(const Circle &c) const
 {
-	return dist(c.center) <= c.radius;
+	/* squared, so there's no sqrt; SegmentBatch does the same test */
+	Vector d(closestPoint(c.center), c.center);
+	return Vector::dot(d,d) <= c.radius * c.radius;
 }
 
 bool Segment::faces(const Point &p) const
@@ -81,7 +83,7 @@ Segment::IntersectType Segment::intersect(const Segment &s, Point &p0, Point &p1
 	Vector	  u = s1.p1 - s1.p0;
 	Vector	  v = s2.p1 - s2.p0;
 	Vector	  w = s1.p0 - s2.p0;
-	float	  D = Vector::perp(u,v);
+	real	  D = Vector::perp(u,v);
 
 	// test if they are parallel (includes either being a point)
 	if (fabs(D) < FLOAT_EPSILON)		// s1 and s2 are parallel
@@ -93,8 +95,8 @@ Segment::IntersectType Segment::intersect(const Segment &s, Point &p0, Point &p1
 
 		// they are collinear or degenerate
 		// check if they are degenerate points
-		float du = Vector::dot(u,u);
-		float dv = Vector::dot(v,v);
+		real du = Vector::dot(u,u);
+		real dv = Vector::dot(v,v);
 		if (du==0 && dv==0) {			// both segments are points
 			if (s1.p0 != s2.p0) 		// they are distinct points
 				return DISJOINT;
@@ -115,7 +117,7 @@ Segment::IntersectType Segment::intersect(const Segment &s, Point &p0, Point &p1
 		}
 
 		// they are collinear segments - get overlap (or not)
-		float t0, t1;					// endpoints of s1 in eqn for s2
+		real t0, t1;					// endpoints of s1 in eqn for s2
 		Vector w2 = s1.p1 - s2.p0;
 		if (v.u != 0) {
 				t0 = w.u / v.u;
@@ -131,8 +133,8 @@ Segment::IntersectType Segment::intersect(const Segment &s, Point &p0, Point &p1
 		if (t0 > 1 || t1 < 0) {
 			return DISJOINT;			// NO overlap
 		}
-		t0 = std::max<float>(0, t0);	// clip to min 0
-		t1 = std::min<float>(1, t1);	// clip to max 1
+		t0 = std::max<real>(0, t0);	// clip to min 0
+		t1 = std::min<real>(1, t1);	// clip to max 1
 
 		if (t0 == t1) { 				// intersect is a point
 			p0= s2.p0 + t0 * v;
@@ -147,12 +149,12 @@ Segment::IntersectType Segment::intersect(const Segment &s, Point &p0, Point &p1
 
 	// the segments are skew and may intersect in a point
 	// get the intersect parameter for S1
-	float	  sI = Vector::perp(v,w) / D;
+	real	  sI = Vector::perp(v,w) / D;
 	if (sI < 0 || sI > 1)				// no intersect with S1
 		return DISJOINT;
 
 	// get the intersect parameter for S2
-	float	  tI = Vector::perp(u,w) / D;
+	real	  tI = Vector::perp(u,w) / D;
 	if (tI < 0 || tI > 1)				// no intersect with S2
 		return DISJOINT;
 
@@ -0,0 +1,173 @@
+/***************************************************************************
+* SimFun
+*  segmentbatch.cpp -- tests a circle against many segments at once
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include "segmentbatch.h"
+
+#if defined(__SSE__) && !defined(SIMFUN_FIXED_POINT)
+#include <xmmintrin.h>
+#endif
+
+/* unused lanes at the end of the last group: far enough away that the
+	squared distance is infinite, so they never hit. fixed point has no
+	infinity, so there it's just further than any map, with room to square */
+#ifdef SIMFUN_FIXED_POINT
+static const real FAR_AWAY = 16384;
+#else
+static const real FAR_AWAY = 1e30f;
+#endif
+
+void SegmentBatch::clear()
+{
+	data.clear();
+	mask.clear();
+	count = 0;
+}
+
+void SegmentBatch::reserve(int n)
+{
+	data.reserve(((n + LANES - 1) / LANES) * GROUP_SIZE);
+	mask.reserve((n + 31) / 32);
+}
+
+void SegmentBatch::add(const Segment &s)
+{
+	int lane = count % LANES;
+	if (lane == 0) data.resize(data.size() + GROUP_SIZE, FAR_AWAY);
+	if (count % 32 == 0) mask.push_back(0);
+
+	/* the same arithmetic as Segment::closestPoint, done ahead of time */
+	Vector v = s.p1 - s.p0;
+	real *group = &data[data.size() - GROUP_SIZE];
+	group[X0 * LANES + lane] = s.p0.x;
+	group[Y0 * LANES + lane] = s.p0.y;
+	group[X1 * LANES + lane] = s.p1.x;
+	group[Y1 * LANES + lane] = s.p1.y;
+	group[DX * LANES + lane] = v.u;
+	group[DY * LANES + lane] = v.v;
+	group[LEN2 * LANES + lane] = Vector::dot(v,v);
+
+	count++;
+}
+
+#if defined(__SSE__) && !defined(SIMFUN_FIXED_POINT)
+
+int SegmentBatch::intersectGroup(const real *group, const Circle &c)
+{
+	__m128 cx = _mm_set1_ps(c.center.x), cy = _mm_set1_ps(c.center.y);
+	__m128 r2 = _mm_set1_ps(c.radius * c.radius);
+
+	__m128 x0 = _mm_loadu_ps(group + X0 * LANES), y0 = _mm_loadu_ps(group + Y0 * LANES);
+	__m128 dx = _mm_loadu_ps(group + DX * LANES), dy = _mm_loadu_ps(group + DY * LANES);
+	__m128 len2 = _mm_loadu_ps(group + LEN2 * LANES);
+
+	/* projection of the center onto each segment... */
+	__m128 c1 = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(cx, x0), dx),
+		_mm_mul_ps(_mm_sub_ps(cy, y0), dy));
+	__m128 t = _mm_div_ps(c1, len2);
+	__m128 px = _mm_add_ps(x0, _mm_mul_ps(t, dx));
+	__m128 py = _mm_add_ps(y0, _mm_mul_ps(t, dy));
+
+	/* ...clamped to the end points */
+	__m128 atEnd = _mm_cmple_ps(len2, c1);
+	px = _mm_or_ps(_mm_and_ps(atEnd, _mm_loadu_ps(group + X1 * LANES)), _mm_andnot_ps(atEnd, px));
+	py = _mm_or_ps(_mm_and_ps(atEnd, _mm_loadu_ps(group + Y1 * LANES)), _mm_andnot_ps(atEnd, py));
+
+	__m128 atStart = _mm_cmple_ps(c1, _mm_setzero_ps());
+	px = _mm_or_ps(_mm_and_ps(atStart, x0), _mm_andnot_ps(atStart, px));
+	py = _mm_or_ps(_mm_and_ps(atStart, y0), _mm_andnot_ps(atStart, py));
+
+	__m128 ex = _mm_sub_ps(cx, px), ey = _mm_sub_ps(cy, py);
+	__m128 d2 = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+
+	return _mm_movemask_ps(_mm_cmple_ps(d2, r2));
+}
+
+#else
+
+int SegmentBatch::intersectGroup(const real *group, const Circle &c)
+{
+	real r2 = c.radius * c.radius;
+	int bits = 0;
+
+	for (int i = 0; i < LANES; i++)
+	{
+		Point p0(group[X0 * LANES + i], group[Y0 * LANES + i]);
+		Point p1(group[X1 * LANES + i], group[Y1 * LANES + i]);
+		Vector v(group[DX * LANES + i], group[DY * LANES + i]);
+		real len2 = group[LEN2 * LANES + i];
+
+		real c1 = Vector::dot(c.center - p0, v);
+		Point p = (c1 <= 0) ? p0 : (len2 <= c1) ? p1 : p0 + (c1 / len2) * v;
+
+		Vector d(p, c.center);
+		if (Vector::dot(d,d) <= r2) bits |= 1 << i;
+	}
+
+	return bits;
+}
+
+#endif
+
+int SegmentBatch::intersect(const Circle &c)
+{
+	return intersect(&c, 1);
+}
+
+int SegmentBatch::intersect(const Circle *circles, int n)
+{
+	int hits = 0, groups = (count + LANES - 1) / LANES;
+
+	for (unsigned int i = 0; i < mask.size(); i++)
+		mask[i] = 0;
+
+	for (int g = 0; g < groups; g++)
+	{
+		const real *group = &data[g * GROUP_SIZE];
+		int bits = 0;
+
+		for (int i = 0; i < n; i++)
+			bits |= intersectGroup(group, circles[i]);
+
+		if (bits == 0) continue;
+
+		/* 8 groups of 4 per mask word */
+		mask[g >> 3] |= (unsigned int)bits << ((g & 7) * LANES);
+		for (; bits; bits &= bits - 1)
+			hits++;
+	}
+
+	return hits;
+}
+
+bool SegmentBatch::intersectAny(const Circle &c) const
+{
+	int groups = (count + LANES - 1) / LANES;
+
+	for (int g = 0; g < groups; g++)
+		if (intersectGroup(&data[g * GROUP_SIZE], c))
+			return true;
+
+	return false;
+}
@@ -22,15 +22,73 @@
 *
 *****************************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
+#include "botinput.h"
+#include "level.h"
+#include "misc.h"
 #include "simulation.h"
 
 int main(int argc, char **argv) 
 {
 	Simulation &sim = Simulation::get();
+	Renderer::Backend backend = Renderer::AUTO;
+	const char *captureFile = NULL, *replayFile = NULL, *recordFile = NULL;
+	bool vsync = true, bot = false;
 
-	sim.initGraphics();
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-legacy") == 0)
+			backend = Renderer::LEGACY;
+		else if (strcmp(argv[i], "-gl3") == 0)
+			backend = Renderer::GL3;
+		else if (strcmp(argv[i], "-novsync") == 0)
+			vsync = false;
+		else if (strcmp(argv[i], "-capture") == 0 && i + 1 < argc)
+			captureFile = argv[++i];
+		else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+			replayFile = argv[++i];
+		else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+			recordFile = argv[++i];
+		else if (strcmp(argv[i], "-bot") == 0)
+			bot = true;
+		else if (strcmp(argv[i], "-loadthreads") == 0 && i + 1 < argc)
+			Level::setThreads(atoi(argv[++i]));
+	}
+
+	sim.initGraphics(backend, vsync);
 	sim.initData();
+
+	/* where the player's buttons come from */
+	InputSource *source = &sim.getKeyboard();
+	BotInput botInput(sim.getPlayer(), sim.getBackground());
+	ReplayInput replay;
+
+	if (replayFile)
+	{
+		if (!replay.load(replayFile)) return 1;
+		if (replay.getMap() < 0 || replay.getMap() >= Simulation::getNumMaps())
+		{
+			ErrorBox("Unable to load %s: no map %d\n", replayFile, replay.getMap());
+			return 1;
+		}
+
+		/* start from where the recording did */
+		sim.loadMapNow(replay.getMap());
+		setRandomState(replay.getRandomState());
+		source = &replay;
+	}
+	else if (bot)
+		source = &botInput;
+
+	RecordInput record(source, sim.getCurrentMap(), getRandomState());
+	if (recordFile) source = &record;
+
+	sim.setInput(source);
+	if (captureFile) sim.startCapture(captureFile);
 	sim.mainLoop();
 
+	if (recordFile) record.save(recordFile);
+
 	return 0;
 }
\ No newline at end of file
@@ -22,16 +22,31 @@
 *
 *****************************************************************************/
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "SDL_opengl.h"
 #include "SDL.h"
+#include "alloctrack.h"
 #include "simulation.h"
 #include "misc.h"
 
-#define MEDIA_DIR "..\\data\\"
+/* relative to bin; windows takes forward slashes too */
+#define MEDIA_DIR "../data/"
 
-/* frame rate is given in ms */
-const int Simulation::FRAME_RATE = 1000/60;
+/* frames per second */
+const int Simulation::FRAME_RATE = 60;
+
+const char *Simulation::CAPTION = "SimFun -- Simulation of Fun";
+
+const int Simulation::AGENTS_PER_SPAWN = 10;
+
+const Uint32 Simulation::SNAPSHOT_MAGIC = 0x4e534653; /* "SFSN" */
+
+/* in ticks; about 130ms */
+const int Simulation::LOOPBACK_LATENCY = 8;
+
+const size_t Simulation::FRAME_ARENA_SIZE = 16 * 1024;
 
 static const struct
 {
@@ -41,10 +56,71 @@ static const struct
 {
 	{ MEDIA_DIR "map1.txt", 270, 250 },
 	{ MEDIA_DIR "map2.txt", 40, 20 },
-	{ MEDIA_DIR "map3.txt", 80, 430 }
+	{ MEDIA_DIR "map3.txt", 80, 430 },
+	{ MEDIA_DIR "map4.txt", 320, 120 }
 };
 
-void Simulation::initGraphics()
+static const int numMaps = sizeof(mapData) / sizeof(mapData[0]);
+
+/* the tag each part of a tick runs under, in the order they run */
+static const AllocTracker::Tag phaseTags[Simulation::PhaseTimes::NUM_PHASES] =
+{
+	AllocTracker::PLAYER,
+	AllocTracker::AGENTS,
+	AllocTracker::PARTICLES
+};
+
+/* fills in step()'s PhaseTimes, when it's given one; next() ends the
+	part of the tick that's running and starts the one after it */
+class PhaseTimer
+{
+/* fields */
+private:
+	Simulation::PhaseTimes *times;
+	int phase;
+	double start;
+	AllocTracker::Stats before[AllocTracker::NUM_TAGS];
+
+/* constructors */
+public:
+	PhaseTimer(Simulation::PhaseTimes *_times): times(_times), phase(0), start(0)
+	{
+		if (times == NULL) return;
+		AllocTracker::getStats(before);
+		start = getTime();
+	}
+
+/* methods */
+public:
+	void next()
+	{
+		if (times == NULL) return;
+		double end = getTime();
+
+		AllocTracker::Stats after[AllocTracker::NUM_TAGS];
+		AllocTracker::getStats(after);
+
+		const AllocTracker::Stats &a = after[phaseTags[phase]], &b = before[phaseTags[phase]];
+		AllocTracker::Stats &s = times->allocs[phase];
+		s.allocs = a.allocs - b.allocs;
+		s.frees = a.frees - b.frees;
+		s.bytesAllocated = a.bytesAllocated - b.bytesAllocated;
+		s.bytesFreed = a.bytesFreed - b.bytesFreed;
+		times->time[phase] = end - start;
+
+		/* reading the counters isn't part of the next phase */
+		memcpy(before, after, sizeof(before));
+		phase++;
+		start = getTime();
+	}
+};
+
+AllocTracker::Tag Simulation::PhaseTimes::getTag(int phase)
+{
+	return phaseTags[phase];
+}
+
+void Simulation::initGraphics(Renderer::Backend backend, bool vsync)
 {
 	/* intialize sdl */
 	if (SDL_Init(SDL_INIT_VIDEO) < 0)
@@ -52,67 +128,367 @@ void Simulation::initGraphics()
 		ErrorBox("Couldn't initialize SDL video.\n");
 		exit(1);
 	}
-	SDL_WM_SetCaption("SimFun -- Simulation of Fun", NULL);
+	SDL_WM_SetCaption(CAPTION, NULL);
 
 	SDL_GL_SetAttribute(SDL_GL_BUFFER_SIZE, 24);
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	FramePacer::requestVsync(vsync);
 	if ( SDL_SetVideoMode(640, 480, 0, SDL_OPENGL) == NULL )
 	{
 		ErrorBox("Couldn't initialize GL.\n");
 		exit(1);
 	}
+	pacer.setVsync(vsync && FramePacer::hasVsync());
 
 	/* initialize GL */
-    glViewport(0, 0, 640, 480);
-	glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+	Renderer *r = Renderer::create(backend, 640, 480);
+	if (!r) exit(1);
+	setRenderer(r);
+}
 
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	gluOrtho2D(0,640,480,0);
+void Simulation::loadMap(int map)
+{
+	/* the old map stays live until the loader is done with the new one;
+		see checkLoader */
+	requestedMap = map;
+	respawn = true;
+	mapLoader.request(mapData[map].mapName, map, Physics::get());
+}
+
+void Simulation::loadMapNow(int map)
+{
+	Level *level = new Level(bg.getTileWidth(), bg.getTileHeight());
+	if (!level->load(mapData[map].mapName, Physics::get())) exit(1);
 
-	glMatrixMode(GL_MODELVIEW);
+	respawn = true;
+	setLevel(level, map);
 }
 
-void Simulation::loadMap(int map)
+int Simulation::getNumMaps()
 {
-	bg.loadMap(mapData[map].mapName);
+	return numMaps;
+}
 
-	Point p(mapData[map].x, mapData[map].y);
-	player.setPos(p);
-	player.setOldPos(p);
+const char *Simulation::getMapName(int map)
+{
+	return mapData[map].mapName;
 }
 
-void Simulation::initData()
+void Simulation::loadImages(bool upload)
 {
 	/* load background */
-	bg.loadTiles(MEDIA_DIR "tiles.bmp");
+	bg.loadTiles(atlas, MEDIA_DIR "tiles.bmp");
 
 	/* load player */
-	player.loadImage(MEDIA_DIR "SimFunPlayer.bmp");
+	player.loadImage(atlas, MEDIA_DIR "SimFunPlayer.bmp");
 
-	/* load map */
-	loadMap(0);
+	/* pack everything into one texture */
+	if (!atlas.build(upload)) exit(1);
+}
+
+void Simulation::setRenderer(Renderer *r)
+{
+	renderer = r;
+	batch.setRenderer(r);
+}
+
+void Simulation::initData()
+{
+	loadImages();
+
+	/* without the file, the built in values are used */
+	Physics::load(MEDIA_DIR "physics.txt");
+
+	/* load the first map right away, there's nothing to show without it.
+		after that, maps are built on the loader thread */
+	loadMapNow(0);
+	mapLoader.start();
+
+	/* reload assets when they're changed on disk */
+
+	for (int i = 0; i < numMaps; i++)
+		watcher.watch(mapData[i].mapName, i);
+	watcher.watch(MEDIA_DIR "tiles.bmp", IMAGE_ASSET);
+	watcher.watch(MEDIA_DIR "SimFunPlayer.bmp", IMAGE_ASSET);
+	watcher.watch(MEDIA_DIR "physics.txt", PHYSICS_ASSET);
+}
+
+void Simulation::setLevel(Level *level, int map)
+{
+	/* objects remember walls in their ignore lists, which are about to be
+		deleted */
+	player.clearIgnore();
+	agents.clearIgnore();
+	particles.clear();
+
+	bg.setLevel(level);
+	layerCache.invalidate();
+	levelSerial++;
+
+	/* the states in the rollback buffer belong to the old level */
+	rollback.stop();
+
+	/* a map reloaded because it changed on disk keeps the player where
+		it is */
+	if (respawn)
+	{
+		Point p(mapData[map].x, mapData[map].y);
+		player.setPos(p);
+		player.setOldPos(p);
+		agents.clear();
+		respawn = false;
+	}
+
+	currentMap = requestedMap = map;
+}
+
+void Simulation::checkAssets()
+{
+	bool reloadImages = false;
+
+	changedAssets.clear();
+	watcher.poll(changedAssets);
+
+	std::vector<int>::const_iterator i;
+	for (i = changedAssets.begin(); i != changedAssets.end(); ++i)
+	{
+		if (*i == IMAGE_ASSET)
+			reloadImages = true;
+		else if (*i == PHYSICS_ASSET)
+		{
+			/* the jumps in the NavGraph depend on the physics, so the map
+				is built again too */
+			if (Physics::load(MEDIA_DIR "physics.txt"))
+				mapLoader.request(mapData[requestedMap].mapName, requestedMap,
+					Physics::get());
+		}
+		else if (*i == requestedMap)
+			mapLoader.request(mapData[*i].mapName, *i, Physics::get());
+	}
+
+	/* images are small, and the texture has to be uploaded here anyway */
+	if (reloadImages)
+	{
+		atlas.reload();
+		layerCache.invalidate();
+	}
+}
+
+void Simulation::checkLoader()
+{
+	/* swap in a level the loader has finished, between ticks. levels for
+		a map that isn't wanted anymore (1 then 2 pressed quickly) are
+		dropped */
+	int id;
+	Level *level = mapLoader.poll(id);
+
+	if (level && id == requestedMap)
+		setLevel(level, id);
+	else if (level)
+		delete level;
+}
+
+void Simulation::spawnAgents()
+{
+	/* spread them out a bit around the player, so they don't all follow
+		exactly the same path */
+	for (int i = 0; i < AGENTS_PER_SPAWN; i++)
+	{
+		Vector offset((frand()*2-1) * 16, (frand()*2-1) * 8);
+		agents.add(player, player.getPos() + offset);
+	}
+}
+
+void Simulation::saveState(Snapshot &s) const
+{
+	s.clear(&bg.getLevel()->getWalls());
+
+	s.put(SNAPSHOT_MAGIC);
+	s.put(levelSerial);
+	s.put(getRandomState());
+
+	player.save(s);
+	agents.save(s);
+	particles.save(s);
+}
+
+bool Simulation::restoreState(Snapshot &s)
+{
+	Uint32 magic, random;
+	int serial;
+
+	if (s.empty()) return false;
+	s.rewind(&bg.getLevel()->getWalls());
+
+	/* check the header before changing anything */
+	s.get(magic);
+	s.get(serial);
+	s.get(random);
+	if (magic != SNAPSHOT_MAGIC || serial != levelSerial) return false;
+
+	setRandomState(random);
+	player.restore(s);
+	agents.restore(s);
+	particles.restore(s);
+
+	if (s.failed())
+	{
+		/* the objects may hold bad walls now, don't let them keep them */
+		player.clearIgnore();
+		agents.clearIgnore();
+		particles.clear();
+		return false;
+	}
+
+	return true;
 }
 
 void Simulation::draw()
 {
-	glClear(GL_COLOR_BUFFER_BIT);
+	render();
 
-	if (flags & DRAW_TILES) bg.drawTiles();
-	if (flags & DRAW_WALLS) bg.drawWalls();
-	if (flags & DRAW_PLAYER) player.draw();
-	if (flags & DRAW_PARTICLES) particles.draw();
+	/* if the writer is behind, the frame is skipped rather than waiting */
+	if (Uint8 *pixels = capture.beginFrame(false))
+	{
+		renderer->readPixels(pixels, 640, 480);
+		capture.endFrame();
+	}
 
 	glFlush();
     SDL_GL_SwapBuffers();
 }
 
+bool Simulation::startCapture(const char *file)
+{
+	return capture.start(file, 640, 480, FRAME_RATE);
+}
+
+void Simulation::render()
+{
+	AllocTracker::Scope scope(AllocTracker::RENDER);
+
+	int layers = flags & (DRAW_TILES | DRAW_WALLS);
+	bool cached = (flags & DRAW_CACHED) && layers;
+
+	/* the cached layers cover the whole screen, so there's nothing to
+		clear */
+	if (cached && layerCache.isValid(layers))
+		layerCache.draw(*renderer);
+	else
+	{
+		renderer->clear();
+
+		/* the batch draws its lines after its quads, so the walls have to
+			be flushed before anything goes over them */
+		if (flags & DRAW_TILES) bg.drawTiles(batch);
+		if (flags & DRAW_WALLS)
+		{
+			bg.drawWalls(batch);
+			batch.flush();
+		}
+
+		if (cached)
+		{
+			batch.flush();
+			layerCache.capture(layers);
+		}
+	}
+	if (flags & DRAW_PLAYER)
+	{
+		player.draw(batch);
+		agents.draw(batch);
+	}
+	if (flags & DRAW_PARTICLES) particles.draw(batch);
+	batch.flush();
+
+	renderer->finish();
+}
+
 void Simulation::update()
 {
-	Uint8 *keys = SDL_GetKeyState(NULL);
-	player.getInput(keys);
-	player.update();
-	particles.update();
+	int buttons = input->nextButtons();
+
+	if (rollback.isRunning())
+		rollback.advance(buttons);
+	else
+		step(&buttons, 1);
+}
+
+void Simulation::step(const int *inputs, int count, PhaseTimes *times)
+{
+	PhaseTimer timer(times);
+
+	frameArena.reset();
+
+	{
+		AllocTracker::Scope scope(AllocTracker::PLAYER);
+		player.setInput(inputs[0]);
+		player.update();
+	}
+	timer.next();
+
+	{
+		AllocTracker::Scope scope(AllocTracker::AGENTS);
+		for (int i = 0; i < agents.size(); i++)
+			agents.setInput(i, i + 1 < count ? inputs[i + 1] : inputs[0]);
+		agents.update(bg);
+	}
+	timer.next();
+
+	{
+		AllocTracker::Scope scope(AllocTracker::PARTICLES);
+		particles.update();
+	}
+	timer.next();
+}
+
+void Simulation::toggleLoopback()
+{
+	if (rollback.isRunning())
+	{
+		rollback.stop();
+		return;
+	}
+
+	/* the first agent plays the remote player, which gets our inputs back
+		through the loopback */
+	if (agents.size() == 0)
+		agents.add(player, player.getPos());
+
+	loopback.clear();
+	rollback.start(2, 0, &loopback);
+}
+
+void Simulation::toggleFrameStats()
+{
+	showStats = !showStats;
+	statsTime = getTime();
+
+	/* start counting from now */
+	FramePacer::Stats stats;
+	pacer.takeStats(stats);
+	keyboard.takeLatency();
+
+	if (!showStats) SDL_WM_SetCaption(CAPTION, NULL);
+}
+
+void Simulation::showFrameStats()
+{
+	/* once a second is enough to read */
+	double now = getTime();
+	if (now - statsTime < 1) return;
+	statsTime = now;
+
+	FramePacer::Stats s;
+	pacer.takeStats(s);
+	if (s.frames == 0) return;
+
+	char caption[256];
+	snprintf(caption, sizeof(caption),
+		"SimFun -- %.1f fps, %.2f ms (+/- %.2f, %.2f to %.2f), %d late, input %.2f ms",
+		1 / s.average, s.average * 1000, s.deviation * 1000,
+		s.min * 1000, s.max * 1000, s.late, keyboard.takeLatency() * 1000);
+	SDL_WM_SetCaption(caption, NULL);
 }
 
 void Simulation::mainLoop()
@@ -125,20 +501,22 @@ void Simulation::mainLoop()
 
 		if (active)
 		{
-			int tickStart = SDL_GetTicks(), tickEnd;
-
+			checkAssets();
+			checkLoader();
 			update();
 			draw();
 
 			/* keep constant frame rate (if we're drawing too fast) */
-			tickEnd = SDL_GetTicks();
-			if (tickEnd - tickStart < FRAME_RATE)
-				SDL_Delay(FRAME_RATE - (tickEnd - tickStart));
+			pacer.wait();
+			if (showStats) showFrameStats();
 		}
 		else
 		{
 			SDL_WaitEvent(&event);
 			SDL_PushEvent(&event);
+
+			/* the pause isn't a late frame */
+			pacer.reset();
 		}
 
 		while ( SDL_PollEvent(&event) ) {
@@ -147,8 +525,15 @@ void Simulation::mainLoop()
 			case SDL_ACTIVEEVENT:
 				if ( (event.active.state & (SDL_APPACTIVE | SDL_APPINPUTFOCUS)) != 0)
 					active = event.active.gain == 1;
+				/* keys let go while away won't send key ups */
+				if (!active) keyboard.reset();
+				break;
+			case SDL_KEYUP:
+				keyboard.handleEvent(event);
 				break;
 			case SDL_KEYDOWN:
+				if (keyboard.handleEvent(event)) break;
+
 				switch (event.key.keysym.sym)
 				{
 				case SDLK_ESCAPE:
@@ -160,12 +545,32 @@ void Simulation::mainLoop()
 				case SDLK_t:
 					flags ^= DRAW_TILES;
 					break;
+				case SDLK_c:
+					flags ^= DRAW_CACHED;
+					break;
+				case SDLK_f:
+					toggleFrameStats();
+					break;
 				case SDLK_p:
 					flags ^= DRAW_PLAYER;
 					break;
 				case SDLK_a:
 					flags ^= DRAW_PARTICLES;
 					break;
+				case SDLK_b:
+					spawnAgents();
+					break;
+				case SDLK_s:
+					saveState(quickSave);
+					break;
+				case SDLK_r:
+					/* the rollback history isn't valid anymore */
+					rollback.stop();
+					restoreState(quickSave);
+					break;
+				case SDLK_n:
+					toggleLoopback();
+					break;
 				case SDLK_1:
 					loadMap(0);
 					break;
@@ -175,6 +580,9 @@ void Simulation::mainLoop()
 				case SDLK_3:
 					loadMap(2);
 					break;
+				case SDLK_4:
+					loadMap(3);
+					break;
 				}
 				break;
 			case SDL_QUIT:
@@ -183,4 +591,6 @@ void Simulation::mainLoop()
 			}
 		}
 	}
+	/* write out whatever is still queued */
+	capture.stop();
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+/***************************************************************************
+* SimFun
+*  snapshot.cpp -- saves and restores the simulation state
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <string.h>
+#include "snapshot.h"
+#include "walls.h"
+
+void Snapshot::clear(const Walls *_walls)
+{
+	data.clear();
+	readPos = 0;
+	overrun = false;
+	walls = _walls;
+}
+
+void Snapshot::rewind(const Walls *_walls)
+{
+	readPos = 0;
+	overrun = false;
+	walls = _walls;
+}
+
+void Snapshot::write(const void *p, unsigned int n)
+{
+	unsigned int pos = data.size();
+	data.resize(pos + n);
+	memcpy(&data[pos], p, n);
+}
+
+bool Snapshot::read(void *p, unsigned int n)
+{
+	if (overrun || readPos + n > data.size())
+	{
+		/* leave the value zeroed, the caller checks failed() at the end */
+		memset(p, 0, n);
+		overrun = true;
+		return false;
+	}
+
+	memcpy(p, &data[readPos], n);
+	readPos += n;
+	return true;
+}
+
+void Snapshot::putWalls(const Wall::CPList &list)
+{
+	put((int)list.size());
+
+	Wall::CPListConstIterator i;
+	for (i = list.begin(); i != list.end(); ++i)
+		put((*i)->index);
+}
+
+bool Snapshot::getWalls(Wall::CPList &list)
+{
+	int n;
+	list.clear();
+	if (!get(n)) return false;
+
+	for (int k = 0; k < n; k++)
+	{
+		int index;
+		if (!get(index)) return false;
+
+		if (walls == NULL || index < 0 || index >= walls->size())
+		{
+			overrun = true;
+			return false;
+		}
+		list.push_back(walls->getWall(index));
+	}
+
+	return true;
+}
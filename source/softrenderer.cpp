@@ -0,0 +1,454 @@
+/***************************************************************************
+* SimFun
+*  softrenderer.cpp -- draws into memory, without GL
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "softrenderer.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* pixels are R, G, B, A in memory, whatever the byte order */
+static Uint32 pack(Uint8 r, Uint8 g, Uint8 b)
+{
+	Uint8 p[4] = { r, g, b, 255 };
+	Uint32 v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+/* x / 255, rounded, for x up to 255 * 255 */
+static int div255(int x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+static Uint32 blend(Uint32 dest, Uint32 color, int alpha)
+{
+	Uint8 *d = (Uint8 *)&dest, *c = (Uint8 *)&color;
+	for (int k = 0; k < 3; k++)
+		d[k] = div255(c[k] * alpha + d[k] * (255 - alpha));
+	return dest;
+}
+
+/* texel times vertex color */
+static Uint32 modulate(Uint32 texel, const Color &c)
+{
+	const Uint8 *t = (const Uint8 *)&texel;
+	return pack(div255(t[0] * c.r), div255(t[1] * c.g), div255(t[2] * c.b));
+}
+
+/* first pixel whose center is at or past x */
+static int pixelEdge(float x)
+{
+	return (int)ceil(x - 0.5f);
+}
+
+static bool isAxisAligned(const SpriteVertex *v)
+{
+	/* SpriteBatch's order: upper left, lower left, lower right, upper
+		right */
+	return v[0].x == v[1].x && v[2].x == v[3].x && v[0].y == v[3].y &&
+		v[1].y == v[2].y && v[0].x < v[3].x && v[0].y < v[1].y &&
+		v[0].u == v[1].u && v[2].u == v[3].u && v[0].v == v[3].v &&
+		v[1].v == v[2].v;
+}
+
+SoftRenderer::SoftRenderer(int _width, int _height, int numBands):
+	width(_width), height(_height), pixels(_width * _height),
+	clearColor(pack(255, 255, 255)), cleared(false),
+	lock(NULL), wake(NULL), done(NULL), frame(0), bandsDone(0), quit(false)
+{
+	numBands = std::max(1, std::min(numBands, height));
+	bands.resize(numBands);
+
+	for (int i = 0; i < numBands; i++)
+	{
+		Band &b = bands[i];
+		b.renderer = this;
+		b.top = height * i / numBands;
+		b.bottom = height * (i + 1) / numBands;
+		b.thread = NULL;
+	}
+
+	if (numBands > 1)
+	{
+		lock = SDL_CreateMutex();
+		wake = SDL_CreateCond();
+		done = SDL_CreateCond();
+
+		for (int i = 1; i < numBands; i++)
+			bands[i].thread = SDL_CreateThread(threadFunc, &bands[i]);
+	}
+}
+
+SoftRenderer::~SoftRenderer()
+{
+	if (lock)
+	{
+		SDL_mutexP(lock);
+		quit = true;
+		SDL_CondBroadcast(wake);
+		SDL_mutexV(lock);
+
+		for (unsigned int i = 1; i < bands.size(); i++)
+			SDL_WaitThread(bands[i].thread, NULL);
+
+		SDL_DestroyCond(done);
+		SDL_DestroyCond(wake);
+		SDL_DestroyMutex(lock);
+	}
+}
+
+void SoftRenderer::setTexture(GLuint id, const Image &image)
+{
+	unsigned int i;
+	for (i = 0; i < textures.size() && textures[i].id != id; i++);
+	if (i == textures.size()) textures.resize(i + 1);
+
+	Texture &t = textures[i];
+	t.id = id;
+	t.w = image.w;
+	t.h = image.h;
+	t.texels.resize(image.w * image.h);
+
+	for (int y = 0; y < image.h; y++)
+	{
+		const Uint8 *src = image.row(y);
+		for (int x = 0; x < image.w; x++, src += 3)
+			t.texels[y * image.w + x] = pack(src[0], src[1], src[2]);
+	}
+}
+
+Uint32 SoftRenderer::texelAt(const Texture *t, float u, float v)
+{
+	int x = std::min(std::max((int)floor(u * t->w), 0), t->w - 1);
+	int y = std::min(std::max((int)floor(v * t->h), 0), t->h - 1);
+	return t->row(y)[x];
+}
+
+void SoftRenderer::clear()
+{
+	/* everything drawn before is covered */
+	commands.clear();
+	vertices.clear();
+	cleared = true;
+}
+
+void SoftRenderer::draw(Primitive type, GLuint texture, const SpriteVertex *v,
+	int n, bool blend)
+{
+	if (n == 0) return;
+
+	Command c;
+	c.type = type;
+	c.texture = NULL;
+	c.first = vertices.size();
+	c.count = n;
+	c.blend = blend;
+
+	for (unsigned int i = 0; i < textures.size(); i++)
+		if (textures[i].id == texture)
+			c.texture = &textures[i];
+
+	/* nothing to sample from, nothing to draw */
+	if (!c.texture) return;
+
+	commands.push_back(c);
+	vertices.insert(vertices.end(), v, v + n);
+}
+
+void SoftRenderer::finish()
+{
+	if (bands.size() == 1)
+		drawBand(0, height);
+	else
+	{
+		SDL_mutexP(lock);
+		frame++;
+		bandsDone = 0;
+		SDL_CondBroadcast(wake);
+		SDL_mutexV(lock);
+
+		drawBand(bands[0].top, bands[0].bottom);
+
+		SDL_mutexP(lock);
+		while (bandsDone < (int)bands.size() - 1)
+			SDL_CondWait(done, lock);
+		SDL_mutexV(lock);
+	}
+
+	commands.clear();
+	vertices.clear();
+	cleared = false;
+}
+
+void SoftRenderer::readPixels(Uint8 *rgba, int w, int h)
+{
+	/* already in the layout that's wanted */
+	w = std::min(w, width);
+	h = std::min(h, height);
+	for (int j = 0; j < h; j++)
+		memcpy(rgba + j * w * 4, &pixels[j * width], w * 4);
+}
+
+int SoftRenderer::threadFunc(void *data)
+{
+	Band *band = (Band *)data;
+	band->renderer->runBand(*band);
+	return 0;
+}
+
+void SoftRenderer::runBand(Band &band)
+{
+	int seen = 0;
+
+	SDL_mutexP(lock);
+	while (!quit)
+	{
+		if (frame == seen)
+		{
+			SDL_CondWait(wake, lock);
+			continue;
+		}
+
+		/* the commands don't change until every band is done */
+		seen = frame;
+		SDL_mutexV(lock);
+		drawBand(band.top, band.bottom);
+		SDL_mutexP(lock);
+
+		bandsDone++;
+		SDL_CondSignal(done);
+	}
+	SDL_mutexV(lock);
+}
+
+void SoftRenderer::drawBand(int top, int bottom)
+{
+	if (cleared)
+		std::fill(pixels.begin() + top * width, pixels.begin() + bottom * width,
+			clearColor);
+
+	std::vector<Command>::const_iterator i;
+	for (i = commands.begin(); i != commands.end(); ++i)
+	{
+		const Command &c = *i;
+		const SpriteVertex *v = &vertices[c.first];
+
+		if (c.type == QUADS)
+		{
+			for (int k = 0; k + 4 <= c.count; k += 4)
+				drawQuad(c, v + k, top, bottom);
+		}
+		else
+		{
+			for (int k = 0; k + 2 <= c.count; k += 2)
+				drawLine(c, v + k, top, bottom);
+		}
+	}
+}
+
+void SoftRenderer::drawQuad(const Command &c, const SpriteVertex *v, int top,
+	int bottom)
+{
+	/* the common cases: tiles, and flat colored particles */
+	if (isAxisAligned(v) && (copyQuad(c, v, top, bottom) || fillQuad(c, v, top, bottom)))
+		return;
+
+	/* anything else is a parallelogram, v[0] + s * (v[3] - v[0]) +
+		t * (v[1] - v[0]), with s and t from 0 to 1 */
+	float ex = v[3].x - v[0].x, ey = v[3].y - v[0].y;
+	float fx = v[1].x - v[0].x, fy = v[1].y - v[0].y;
+	float det = ex * fy - ey * fx;
+	if (det == 0) return;
+
+	float l = std::min(std::min(v[0].x, v[1].x), std::min(v[2].x, v[3].x));
+	float r = std::max(std::max(v[0].x, v[1].x), std::max(v[2].x, v[3].x));
+	float t = std::min(std::min(v[0].y, v[1].y), std::min(v[2].y, v[3].y));
+	float b = std::max(std::max(v[0].y, v[1].y), std::max(v[2].y, v[3].y));
+
+	int x0 = std::max(pixelEdge(l), 0), x1 = std::min(pixelEdge(r), width);
+	int y0 = std::max(pixelEdge(t), top), y1 = std::min(pixelEdge(b), bottom);
+
+	float du = v[3].u - v[0].u, dv = v[1].v - v[0].v;
+	int alpha = c.blend ? v[0].color.a : 255;
+
+	for (int y = y0; y < y1; y++)
+	{
+		Uint32 *row = &pixels[y * width];
+		float px = x0 + 0.5f - v[0].x, py = y + 0.5f - v[0].y;
+		float s = (px * fy - py * fx) / det, tt = (ex * py - ey * px) / det;
+		float ds = fy / det, dt = -ey / det;
+
+		for (int x = x0; x < x1; x++, s += ds, tt += dt)
+		{
+			if (s < 0 || s >= 1 || tt < 0 || tt >= 1) continue;
+
+			Uint32 texel = texelAt(c.texture, v[0].u + s * du, v[0].v + tt * dv);
+			Uint32 color = modulate(texel, v[0].color);
+			row[x] = alpha == 255 ? color : blend(row[x], color, alpha);
+		}
+	}
+}
+
+bool SoftRenderer::copyQuad(const Command &c, const SpriteVertex *v, int top,
+	int bottom)
+{
+	/* an opaque, unscaled, untinted image on whole pixels is a copy */
+	const Color &col = v[0].color;
+	if (col.r != 255 || col.g != 255 || col.b != 255 || col.a != 255)
+		return false;
+
+	const Texture *image = c.texture;
+	float tu = v[0].u * image->w, tv = v[0].v * image->h;
+	int w = (int)(v[3].x - v[0].x), h = (int)(v[1].y - v[0].y);
+
+	if (v[0].x != floor(v[0].x) || v[0].y != floor(v[0].y) ||
+		tu != floor(tu) || tv != floor(tv) ||
+		v[3].x - v[0].x != w || v[1].y - v[0].y != h ||
+		(v[3].u - v[0].u) * image->w != w || (v[1].v - v[0].v) * image->h != h)
+		return false;
+
+	int x0 = (int)v[0].x, y0 = (int)v[0].y;
+	int l = std::max(x0, 0), r = std::min(x0 + w, width);
+	int t = std::max(y0, top), b = std::min(y0 + h, bottom);
+
+	for (int y = t; y < b && l < r; y++)
+		memcpy(&pixels[y * width + l], image->row((int)tv + y - y0) + (int)tu + l - x0,
+			(r - l) * sizeof(Uint32));
+
+	return true;
+}
+
+bool SoftRenderer::fillQuad(const Command &c, const SpriteVertex *v, int top,
+	int bottom)
+{
+	/* a quad that only covers texels of one color (the white sprite) is
+		a flat color */
+	const Texture *image = c.texture;
+	int tx0 = std::max((int)floor(v[0].u * image->w), 0);
+	int tx1 = std::min((int)ceil(v[3].u * image->w), image->w);
+	int ty0 = std::max((int)floor(v[0].v * image->h), 0);
+	int ty1 = std::min((int)ceil(v[1].v * image->h), image->h);
+
+	if (tx1 <= tx0 || ty1 <= ty0 || (tx1 - tx0) * (ty1 - ty0) > 16)
+		return false;
+
+	Uint32 first = image->row(ty0)[tx0];
+	for (int y = ty0; y < ty1; y++)
+		for (int x = tx0; x < tx1; x++)
+			if (image->row(y)[x] != first)
+				return false;
+
+	int l = std::max(pixelEdge(v[0].x), 0), r = std::min(pixelEdge(v[3].x), width);
+	int t = std::max(pixelEdge(v[0].y), top), b = std::min(pixelEdge(v[1].y), bottom);
+
+	Uint32 color = modulate(first, v[0].color);
+	int alpha = c.blend ? v[0].color.a : 255;
+
+	for (int y = t; y < b && l < r; y++)
+		blendRow(&pixels[y * width + l], color, alpha, r - l);
+
+	return true;
+}
+
+void SoftRenderer::drawLine(const Command &c, const SpriteVertex *v, int top,
+	int bottom)
+{
+	Uint32 color = modulate(texelAt(c.texture, v[0].u, v[0].v), v[0].color);
+	int alpha = c.blend ? v[0].color.a : 255;
+
+	/* one pixel per pixel center along the longer axis. a line right
+		between two pixels goes to the one with the lower GL window
+		coordinate, like Mesa: left, and (with y going down) below */
+	float dx = v[1].x - v[0].x, dy = v[1].y - v[0].y;
+	bool xMajor = fabs(dx) >= fabs(dy);
+	const SpriteVertex &a = (xMajor ? dx : dy) < 0 ? v[1] : v[0];
+	const SpriteVertex &b = (xMajor ? dx : dy) < 0 ? v[0] : v[1];
+
+	if (xMajor)
+	{
+		if (dx == 0) return;
+		float slope = dy / dx;
+		int x1 = std::min(pixelEdge(b.x), width);
+
+		for (int x = std::max(pixelEdge(a.x), 0); x < x1; x++)
+		{
+			int y = (int)floor(a.y + (x + 0.5f - a.x) * slope);
+			if (y >= top && y < bottom)
+				blendRow(&pixels[y * width + x], color, alpha, 1);
+		}
+	}
+	else
+	{
+		float slope = dx / dy;
+		int y1 = std::min(pixelEdge(b.y), bottom);
+
+		for (int y = std::max(pixelEdge(a.y), top); y < y1; y++)
+		{
+			int x = (int)ceil(a.x + (y + 0.5f - a.y) * slope - 1);
+			if (x >= 0 && x < width)
+				blendRow(&pixels[y * width + x], color, alpha, 1);
+		}
+	}
+}
+
+void SoftRenderer::blendRow(Uint32 *dest, Uint32 color, int alpha, int n)
+{
+	if (alpha == 255)
+	{
+		std::fill(dest, dest + n, color);
+		return;
+	}
+
+#ifdef __SSE2__
+	/* 4 pixels at a time, 16 bits per channel */
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i src = _mm_mullo_epi16(
+		_mm_unpacklo_epi8(_mm_set1_epi32(color), zero), _mm_set1_epi16(alpha));
+	const __m128i inv = _mm_set1_epi16(255 - alpha), round = _mm_set1_epi16(128);
+
+	for (; n >= 4; n -= 4, dest += 4)
+	{
+		__m128i d = _mm_loadu_si128((const __m128i *)dest);
+		__m128i lo = _mm_add_epi16(_mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), src), round);
+		__m128i hi = _mm_add_epi16(_mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), src), round);
+
+		/* same as div255 */
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+		_mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(lo, hi));
+	}
+#endif
+
+	for (; n > 0; n--, dest++)
+		*dest = blend(*dest, color, alpha);
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+* SimFun
+*  spritebatch.cpp -- collects textured quads and draws them all at once
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+#include "spritebatch.h"
+
+const Color SpriteBatch::White(255,255,255,255);
+
+void SpriteBatch::addVertex(std::vector<SpriteVertex> &list, float x, float y,
+	float u, float v, const Color &c)
+{
+	SpriteVertex sv;
+	sv.x = x; sv.y = y;
+	sv.u = u; sv.v = v;
+	sv.color = c;
+	list.push_back(sv);
+}
+
+void SpriteBatch::draw(const Sprite &s, float x, float y, float w, float h,
+	const Color &c)
+{
+	addVertex(vertices, x,   y,   s.u0, s.v0, c);
+	addVertex(vertices, x,   y+h, s.u0, s.v1, c);
+	addVertex(vertices, x+w, y+h, s.u1, s.v1, c);
+	addVertex(vertices, x+w, y,   s.u1, s.v0, c);
+}
+
+void SpriteBatch::draw(const Sprite &s, const Point corners[4], const Color &c)
+{
+	addVertex(vertices, corners[0].x, corners[0].y, s.u0, s.v0, c);
+	addVertex(vertices, corners[1].x, corners[1].y, s.u0, s.v1, c);
+	addVertex(vertices, corners[2].x, corners[2].y, s.u1, s.v1, c);
+	addVertex(vertices, corners[3].x, corners[3].y, s.u1, s.v0, c);
+}
+
+void SpriteBatch::line(const Point &p0, const Point &p1, const Color &c)
+{
+	/* the middle of the white sprite, so the texture doesn't change the
+		color */
+	const Sprite &s = atlas.getWhite();
+	float u = (s.u0 + s.u1) / 2, v = (s.v0 + s.v1) / 2;
+
+	addVertex(lines, p0.x, p0.y, u, v, c);
+	addVertex(lines, p1.x, p1.y, u, v, c);
+}
+
+void SpriteBatch::flush()
+{
+	/* everything in the batch comes from the atlas, so it's one draw for
+		the quads and one for the lines */
+	if (!vertices.empty())
+		renderer->draw(Renderer::QUADS, atlas.getTexture(), &vertices[0],
+			vertices.size(), true);
+	if (!lines.empty())
+		renderer->draw(Renderer::LINES, atlas.getTexture(), &lines[0],
+			lines.size(), false);
+
+	/* clear() keeps the capacity, so after the first few frames the batch
+		doesn't allocate */
+	vertices.clear();
+	lines.clear();
+}
@@ -23,17 +23,17 @@
 *****************************************************************************/
 
 #include <assert.h>
+#include "arena.h"
 #include "tilemap.h"
 
-TileMap::TileMap(unsigned int _width, unsigned int _height):
+TileMap::TileMap(unsigned int _width, unsigned int _height, Arena &arena):
 	width(_width), height(_height)
 {
-	map = new TileMapEntry [_width * _height];
-}
+	map = (TileMapEntry *)arena.allocate(width * height * sizeof(TileMapEntry),
+		AlignOf<TileMapEntry>::value);
 
-TileMap::~TileMap()
-{
-	delete [] map;
+	for (unsigned int i = 0; i < width * height; i++)
+		new (&map[i]) TileMapEntry(&arena);
 }
 
 TileMapEntry * TileMap::index(int i, int j)
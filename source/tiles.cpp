@@ -22,38 +22,114 @@
 *
 *****************************************************************************/
 
+#include <algorithm>
+#include <assert.h>
+#include <stdlib.h>
 #include "tiles.h"
 
 const unsigned int Tile::tileWidth = 8;
 const unsigned int Tile::tileHeight = 8;
 
+GridEdge GridEdge::at(int i, int j) const
+{
+	int x = i * Tile::GRID_SIZE, y = j * Tile::GRID_SIZE;
+	return GridEdge(GridPoint(p0.x + x, p0.y + y), GridPoint(p1.x + x, p1.y + y), type);
+}
+
+Segment::IntersectType GridEdge::intersect(const GridEdge &t, GridPoint &r0, GridPoint &r1) const
+{
+	/* Segment::intersect, in integers. tile edges are never points, so
+		that case is left out */
+	int ux = p1.x - p0.x, uy = p1.y - p0.y;
+	int vx = t.p1.x - t.p0.x, vy = t.p1.y - t.p0.y;
+	int wx = p0.x - t.p0.x, wy = p0.y - t.p0.y;
+	int d = ux * vy - uy * vx;
+
+	if (d != 0)
+	{
+		/* skew; they cross if both intersect parameters are in 0..1 */
+		int s = vx * wy - vy * wx, u = ux * wy - uy * wx;
+		if (d < 0) { d = -d; s = -s; u = -u; }
+		if (s < 0 || s > d || u < 0 || u > d) return Segment::DISJOINT;
+		return Segment::POINT;
+	}
+
+	if (ux * wy - uy * wx != 0 || vx * wy - vy * wx != 0)
+		return Segment::DISJOINT;
+
+	/* collinear; where this edge's ends are along t, scaled by t's
+		length squared */
+	int len = vx * vx + vy * vy;
+	int a = wx * vx + wy * vy;
+	int b = (p1.x - t.p0.x) * vx + (p1.y - t.p0.y) * vy;
+	int lo = std::min(a, b), hi = std::max(a, b);
+
+	if (lo > len || hi < 0) return Segment::DISJOINT;
+	lo = std::max(lo, 0);
+	hi = std::min(hi, len);
+
+	/* the overlap always starts and ends at one of the four ends */
+	const GridPoint *lop = lo == 0 ? &t.p0 : lo == len ? &t.p1 : lo == a ? &p0 : &p1;
+	const GridPoint *hip = hi == 0 ? &t.p0 : hi == len ? &t.p1 : hi == a ? &p0 : &p1;
+
+	r0 = *lop;
+	if (lo == hi) return Segment::COLLINEAR_POINT;
+
+	r1 = *hip;
+	return Segment::SEGMENT;
+}
+
+bool GridEdge::contains(const GridEdge &e) const
+{
+	GridPoint r0, r1;
+	return intersect(e, r0, r1) == Segment::SEGMENT && r0 == e.p0 && r1 == e.p1;
+}
+
+bool GridEdge::sameDirection(const GridEdge &e) const
+{
+	/* for collinear edges, the same normal */
+	return (p1.x - p0.x) * (e.p1.x - e.p0.x) + (p1.y - p0.y) * (e.p1.y - e.p0.y) > 0;
+}
+
+bool GridEdge::sameLine(const GridEdge &e) const
+{
+	int ux = p1.x - p0.x, uy = p1.y - p0.y;
+	return ux * (e.p0.y - p0.y) - uy * (e.p0.x - p0.x) == 0 &&
+		ux * (e.p1.y - p0.y) - uy * (e.p1.x - p0.x) == 0;
+}
+
+Segment GridEdge::toSegment() const
+{
+	return Segment(Point(p0.x * SCALE, p0.y * SCALE), Point(p1.x * SCALE, p1.y * SCALE),
+		Tiles::get().getNormal(p1.x - p0.x, p1.y - p0.y));
+}
+
 /* this (sorta) copy constructor flips the tile, so I don't have to do it
 	by hand */
 Tile::Tile(const Tile &t, unsigned int flags)
 {
-	std::list<Edge>::const_iterator i;
+	std::vector<GridEdge>::const_iterator i;
 	for (i= t.edges.begin(); i != t.edges.end(); i++)
 	{
-		const Edge &e = *i;
-		const Segment &s = e.segment;
-		Point p0(s.p0), p1(s.p1);
+		const GridEdge &e = *i;
+		GridPoint p0(e.p0), p1(e.p1);
 
 		if (flags & H_FLIP)
 		{
-			p0.x = tileWidth - p0.x;
-			p1.x = tileWidth - p1.x;
+			p0.x = GRID_SIZE - p0.x;
+			p1.x = GRID_SIZE - p1.x;
 
 			std::swap(p0, p1);
 		}
 		if (flags & V_FLIP)
 		{
-			p0.y = tileHeight - p0.y;
-			p1.y = tileHeight - p1.y;
+			p0.y = GRID_SIZE - p0.y;
+			p1.y = GRID_SIZE - p1.y;
 
 			std::swap(p0, p1);
 		}
 
-		edges.push_back( Edge( Segment( p0, p1 ), e.type) );
+		edges.push_back( GridEdge( p0, p1, e.type) );
 	}
 }
 
@@ -71,10 +147,10 @@ Tile::Tile(const Tile &t, unsigned int flags)
 */
 void Tiles::makeTiles()
 {
-	Point ul(0,0);
-	Point ur(Tile::tileWidth, 0);
-	Point dr(Tile::tileWidth, Tile::tileHeight);
-	Point dl(0, Tile::tileHeight);
+	GridPoint ul(0,0);
+	GridPoint ur(Tile::GRID_SIZE, 0);
+	GridPoint dr(Tile::GRID_SIZE, Tile::GRID_SIZE);
+	GridPoint dl(0, Tile::GRID_SIZE);
 
 	{
 		/* Empty */
@@ -86,10 +162,10 @@ void Tiles::makeTiles()
 	{
 		/* Ladder */
 		Tile t;
-		t.addEdge( Edge( Segment(ul, ur), Edge::LADDER_TOP) );
-		t.addEdge( Edge( Segment(ur, dr), Edge::LADDER) );
-		t.addEdge( Edge( Segment(dr, dl), Edge::LADDER) );
-		t.addEdge( Edge( Segment(dl, ul), Edge::LADDER) );
+		t.addEdge( GridEdge(ul, ur, Edge::LADDER_TOP) );
+		t.addEdge( GridEdge(ur, dr, Edge::LADDER) );
+		t.addEdge( GridEdge(dr, dl, Edge::LADDER) );
+		t.addEdge( GridEdge(dl, ul, Edge::LADDER) );
 
 		addTile(Tile::LADDER, t);
 	}
@@ -97,10 +173,10 @@ void Tiles::makeTiles()
 	{
 		/* Water */
 		Tile t;
-		t.addEdge( Edge( Segment(ul, ur), Edge::WATER) );
-		t.addEdge( Edge( Segment(ur, dr), Edge::WATER) );
-		t.addEdge( Edge( Segment(dr, dl), Edge::WATER) );
-		t.addEdge( Edge( Segment(dl, ul), Edge::WATER) );
+		t.addEdge( GridEdge(ul, ur, Edge::WATER) );
+		t.addEdge( GridEdge(ur, dr, Edge::WATER) );
+		t.addEdge( GridEdge(dr, dl, Edge::WATER) );
+		t.addEdge( GridEdge(dl, ul, Edge::WATER) );
 
 		addTile(Tile::WATER, t);
 	}
@@ -108,10 +184,10 @@ void Tiles::makeTiles()
 	{
 		/* Solid */
 		Tile t;
-		t.addEdge( Edge( Segment(ul, ur), Edge::SOLID) );
-		t.addEdge( Edge( Segment(ur, dr), Edge::SOLID) );
-		t.addEdge( Edge( Segment(dr, dl), Edge::SOLID) );
-		t.addEdge( Edge( Segment(dl, ul), Edge::SOLID) );
+		t.addEdge( GridEdge(ul, ur, Edge::SOLID) );
+		t.addEdge( GridEdge(ur, dr, Edge::SOLID) );
+		t.addEdge( GridEdge(dr, dl, Edge::SOLID) );
+		t.addEdge( GridEdge(dl, ul, Edge::SOLID) );
 
 		addTile(Tile::SOLID, t);
 	}
@@ -119,8 +195,8 @@ void Tiles::makeTiles()
 	{
 		/* One Way Up/Down */
 		Tile t;
-		t.addEdge( Edge( Segment(ul, ur), Edge::ONE_WAY) );
-		t.addEdge( Edge( Segment(dr, dl), Edge::WEAK) );
+		t.addEdge( GridEdge(ul, ur, Edge::ONE_WAY) );
+		t.addEdge( GridEdge(dr, dl, Edge::WEAK) );
 
 		addTile(Tile::ONE_WAY_U, t);
 		addTile(Tile::ONE_WAY_D, Tile(t, Tile::V_FLIP));
@@ -129,8 +205,8 @@ void Tiles::makeTiles()
 	{
 		/* One Way Left/Right */
 		Tile t;
-		t.addEdge( Edge( Segment(ur, dr), Edge::WEAK) );
-		t.addEdge( Edge( Segment(dl, ul), Edge::ONE_WAY) );
+		t.addEdge( GridEdge(ur, dr, Edge::WEAK) );
+		t.addEdge( GridEdge(dl, ul, Edge::ONE_WAY) );
 
 
 		addTile(Tile::ONE_WAY_L, t);
@@ -140,9 +216,9 @@ void Tiles::makeTiles()
 	{
 		/* 45 degree DL, DR, UL, UR */
 		Tile t;
-		t.addEdge( Edge( Segment( ul, dr), Edge::SOLID) );
-		t.addEdge( Edge( Segment( dr, dl), Edge::SOLID) );
-		t.addEdge( Edge( Segment( dl, ul), Edge::SOLID) );
+		t.addEdge( GridEdge(ul, dr, Edge::SOLID) );
+		t.addEdge( GridEdge(dr, dl, Edge::SOLID) );
+		t.addEdge( GridEdge(dl, ul, Edge::SOLID) );
 
 		addTile(Tile::DL_45, t);
 		addTile(Tile::DR_45, Tile(t, Tile::H_FLIP));
@@ -153,11 +229,11 @@ void Tiles::makeTiles()
 	{
 		/* 26 degree high DL, DR, UL, UR */
 		Tile t;
-		Point p(ur.x, (ur.y + dr.y) / 2);
-		t.addEdge( Edge( Segment( ul, p), Edge::SOLID) );
-		t.addEdge( Edge( Segment( p, dr), Edge::SOLID) );
-		t.addEdge( Edge( Segment( dr, dl), Edge::SOLID) );
-		t.addEdge( Edge( Segment( dl, ul), Edge::SOLID) );
+		GridPoint p(ur.x, (ur.y + dr.y) / 2);
+		t.addEdge( GridEdge(ul, p, Edge::SOLID) );
+		t.addEdge( GridEdge(p, dr, Edge::SOLID) );
+		t.addEdge( GridEdge(dr, dl, Edge::SOLID) );
+		t.addEdge( GridEdge(dl, ul, Edge::SOLID) );
 
 		addTile(Tile::DL_26_1, t);
 		addTile(Tile::DR_26_1, Tile(t, Tile::H_FLIP));
@@ -168,10 +244,10 @@ void Tiles::makeTiles()
 	{
 		/* 26 degree low DL, DR, UL, UR */
 		Tile t;
-		Point p(ul.x, (ul.y + dl.y) / 2);
-		t.addEdge( Edge( Segment( p, dr), Edge::SOLID) );
-		t.addEdge( Edge( Segment( dr, dl), Edge::SOLID) );
-		t.addEdge( Edge( Segment( dl, p), Edge::SOLID) );
+		GridPoint p(ul.x, (ul.y + dl.y) / 2);
+		t.addEdge( GridEdge(p, dr, Edge::SOLID) );
+		t.addEdge( GridEdge(dr, dl, Edge::SOLID) );
+		t.addEdge( GridEdge(dl, p, Edge::SOLID) );
 
 		addTile(Tile::DL_26_2, t);
 		addTile(Tile::DR_26_2, Tile(t, Tile::H_FLIP));
@@ -190,10 +266,10 @@ void Tiles::makeTiles()
 	{
 		/* 63 degree low DL, DR, UL, UR */
 		Tile t;
-		Point p((dr.x + dl.x)/2, dr.y);
-		t.addEdge( Edge( Segment( ul, p), Edge::SOLID) );
-		t.addEdge( Edge( Segment( p, dl), Edge::SOLID) );
-		t.addEdge( Edge( Segment( dl, ul), Edge::SOLID) );
+		GridPoint p((dr.x + dl.x)/2, dr.y);
+		t.addEdge( GridEdge(ul, p, Edge::SOLID) );
+		t.addEdge( GridEdge(p, dl, Edge::SOLID) );
+		t.addEdge( GridEdge(dl, ul, Edge::SOLID) );
 
 		addTile(Tile::DL_63_2, t);
 		addTile(Tile::DR_63_2, Tile(t, Tile::H_FLIP));
@@ -202,3 +278,28 @@ void Tiles::makeTiles()
 	}
 
 }
+
+void Tiles::makeNormals()
+{
+	/* the same as Segment's, but only worked out once per direction */
+	for (int dy = -2; dy <= 2; dy++)
+		for (int dx = -2; dx <= 2; dx++)
+		{
+			Vector n = Vector::perp(Vector((real)dx, (real)dy));
+			n.normalize();
+			normals[dy + 2][dx + 2] = n;
+		}
+}
+
+const Vector &Tiles::getNormal(int dx, int dy) const
+{
+	/* walls are merged from tile edges, so they go the same way as one of
+		them; dividing out the length gets back to that edge's direction */
+	int a = abs(dx), b = abs(dy);
+	while (b) { int r = a % b; a = b; b = r; }
+	if (a > 1) { dx /= a; dy /= a; }
+
+	/* tile edges go at most 2 steps each way */
+	assert(abs(dx) <= 2 && abs(dy) <= 2);
+	return normals[dy + 2][dx + 2];
+}
@@ -22,25 +22,18 @@
 *
 *****************************************************************************/
 
-#include "SDL_opengl.h"
+#include "spritebatch.h"
 #include "vector.h"
 
 /* these constructors definitions must be moved out of vector.h */
 Vector::Vector(const Point &a) : u(a.x), v(a.y) {}
 Vector::Vector(const Point &a, const Point &b): u(b.x-a.x), v(b.y-a.y) {}
 
-void Vector::draw(const Point &p)
+void Vector::draw(SpriteBatch &batch, const Point &p)
 {
 	/* draw a blue vector */
 	/* why blue? */
 	/* ...don't ask stupid questions */
 
-	glColor3f(0.0f, 0.0f, 1.0f);
-
-	glBegin(GL_LINES);
-
-	glVertex2f(p.x, p.y);
-	glVertex2f(p.x + u, p.y + v);
-
-	glEnd();
+	batch.line(p, Point(p.x + u, p.y + v), Color(0,0,255,255));
 }
\ No newline at end of file
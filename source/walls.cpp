@@ -22,38 +22,229 @@
 *
 *****************************************************************************/
 
-#include <set>
+#include <algorithm>
+#include <functional>
 #include <assert.h>
-#include "SDL_opengl.h"
 #include "walls.h"
-#include "background.h"
-#include "wallset.h"
+#include "alloctrack.h"
+#include "level.h"
+#include "spritebatch.h"
+#include "tilemap.h"
 
-Walls::Walls(Background &bg)
+const int Walls::MIN_BAND_ROWS = 8;
+const int Walls::MAX_EDGES = 4;
+
+/* whether e is on one of the lines */
+static bool onLine(const std::vector<GridEdge> &lines, const GridEdge &e)
+{
+	std::vector<GridEdge>::const_iterator i;
+	for (i = lines.begin(); i != lines.end(); ++i)
+		if ((*i).sameLine(e)) return true;
+	return false;
+}
+
+/* whether s could be merged with or cancel one of the walls of tme */
+static bool touches(const GridEdge &s, const TileMapEntry *tme)
+{
+	if (tme == NULL) return false;
+
+	Wall::CPListConstIterator i;
+	for (i = tme->getWalls().begin(); i != tme->getWalls().end(); ++i)
+	{
+		GridPoint p0, p1;
+		Segment::IntersectType it = s.intersect((*i)->grid, p0, p1);
+		if (it == Segment::COLLINEAR_POINT || it == Segment::SEGMENT) return true;
+	}
+	return false;
+}
+
+Walls::Walls(Level &level):
+	arena(&level.getArena()),
+	tileWidth(level.getTileWidth()),
+	walls(Wall::List::allocator_type(arena)),
+	index(Allocator<const Wall *>(arena)),
+	batch(arena),
+	tree(arena)
 {
 	/* basic idea:
-		process all the tiles from the Background map
+		process all the tiles from the Level map
 		(not to be confused with TileMap, which is much cooler)
 	*/
-	TileMap &tilemap = bg.getTileMap();
+	TileMap &tilemap = level.getTileMap();
+	int height = level.getTileHeight();
+	int numBands = std::max(1, std::min(Level::getThreads(), height / MIN_BAND_ROWS));
+	int i;
+
+	/* made here, rather than racing to construct it on the bands */
+	Tiles::get();
+
+	BandVector bands((Allocator<Band>(arena)));
+	bands.reserve(numBands);
+	for (i = 0; i < numBands; i++)
+		bands.push_back(Band(this, &level, height * i / numBands,
+			height * (i + 1) / numBands, arena));
+
+	for (i = 1; i < numBands; i++)
+	{
+		bands[i].fork = arena->fork();
+		bands[i].thread = SDL_CreateThread(bandThread, &bands[i]);
+	}
+
+	buildBand(bands[0]);
+
+	for (i = 1; i < numBands; i++)
+	{
+		Band &b = bands[i];
+
+		/* without a thread, it's built here */
+		if (b.thread) SDL_WaitThread(b.thread, NULL);
+		else buildBand(b);
+		arena->join(b.fork);
+	}
+
+	/* the bands go on the end of the first one, in order, and each is
+		stitched to the ones above it before the next is added */
+	Band &all = bands[0];
+	bool stitched = false;
+
+	for (i = 1; i < numBands; i++)
+	{
+		int first = all.made.size();
+		merge(all, bands[i]);
+		if (stitch(all, bands[i], first, tilemap)) stitched = true;
+	}
+
+	/* the walls stitch made are on the end; everything after this wants
+		them in the order a single band makes them */
+	if (stitched) all.walls.sort(KeyBefore(all.keys));
+	walls.swap(all.walls);
+
+	buildIndex();
+}
+
+int Walls::bandThread(void *data)
+{
+	Band *b = (Band *)data;
+
+	AllocTracker::setTag(AllocTracker::LOADER);
+	b->fork->attach();
+	b->owner->buildBand(*b);
+	Arena::detach();
+	return 0;
+}
+
+void Walls::buildBand(Band &b)
+{
+	Level &level = *b.level;
+	TileMap &tilemap = level.getTileMap();
 	int i, j;
 
-	for (j = 0; j < 60; j++)
-		for (i= 0; i < 80; i++)
+	for (j = b.top; j < b.bottom; j++)
+		for (i= 0; i < level.getTileWidth(); i++)
 		{
 			Point p(i*8, j*8);
 
 			TileMapEntry *tme = tilemap.index(i,j);
 			assert(tme);
 
-			tme->setTileType(bg.mapIndex(i, j));
+			tme->setTileType(level.mapIndex(i, j));
 			tme->setULCorner(p);
 			tme->setIndex(i,j);
-			addTile(tilemap, *tme);
+			addTile(b, tilemap, *tme);
+		}
+}
+
+void Walls::merge(Band &all, Band &b)
+{
+	/* b's walls are numbered after all's, in the same order, so the
+		walls above still look like they were made first */
+	Wall::ListIterator i;
+	for (i = b.walls.begin(); i != b.walls.end(); ++i)
+	{
+		all.keys.push_back(b.keys[(*i).index]);
+		(*i).index = all.made.size();
+		all.made.push_back(i);
+	}
+
+	all.walls.splice(all.walls.end(), b.walls);
+}
+
+bool Walls::stitch(Band &all, const Band &b, int first, TileMap &tilemap)
+{
+	/* an edge is only merged with or cancelled by walls on the same line,
+		and b only missed the walls in the row above its top. so the lines
+		where an edge in the top row touches one of those are the only
+		ones b could have got wrong */
+	std::vector<GridEdge> lines;
+	unsigned int n;
+	int i, j;
+
+	for (i = 0; i < tileWidth; i++)
+	{
+		const Tile &t = tilemap.index(i, b.top)->getTile();
+
+		for (n = 0; n < t.edges.size(); n++)
+		{
+			const GridEdge s = t.edges[n].at(i, b.top);
+			if (onLine(lines, s)) continue;
+
+			if (touches(s, tilemap.index(i-1, b.top-1)) ||
+				touches(s, tilemap.index(i+0, b.top-1)) ||
+				touches(s, tilemap.index(i+1, b.top-1)))
+				lines.push_back(s);
+		}
+	}
+
+	if (lines.empty()) return false;
+
+	/* throw away b's walls on those lines... */
+	int last = all.made.size();
+	for (int w = first; w < last; w++)
+	{
+		const Wall &wall = *all.made[w];
+		if (!onLine(lines, wall.grid)) continue;
+
+		remapWall(wall, NULL, NULL);
+		removeWall(all, &wall);
+	}
+
+	/* ...and add their edges again, in the same order, now that the walls
+		above are there */
+	for (j = b.top; j < b.bottom; j++)
+		for (i = 0; i < tileWidth; i++)
+		{
+			TileMapEntry &tme = *tilemap.index(i, j);
+			const Tile &t = tme.getTile();
+
+			for (n = 0; n < t.edges.size(); n++)
+			{
+				if (!onLine(lines, t.edges[n].at(i, j))) continue;
+
+				all.key = makeKey(tme, n);
+				addWall(all, t.edges[n], tilemap, tme);
+			}
 		}
+
+	/* the new walls went on the end of their tiles' lists too */
+	Wall::List::reverse_iterator k;
+	for (k = all.walls.rbegin(); k != all.walls.rend() && (*k).index >= last; ++k)
+	{
+		TileMapEntry::PListConstIterator t;
+		for (t = (*k).tiles.begin(); t != (*k).tiles.end(); ++t)
+			(*t)->getWalls().sort(KeyBefore(all.keys));
+	}
+
+	return true;
 }
 
-void Walls::addWall(const Edge &e, TileMap &tilemap, TileMapEntry &tme)
+int Walls::makeKey(const TileMapEntry &tme, int edge) const
+{
+	/* a single band adds the edges in this order, and makes at most two
+		walls for each */
+	return ((tme.getJ() * tileWidth + tme.getI()) * MAX_EDGES + edge) * 2;
+}
+
+void Walls::addWall(Band &b, const GridEdge &e, TileMap &tilemap, TileMapEntry &tme)
 {
 	/* this is a pretty serious function...*/
 	/* basic idea:
@@ -69,28 +260,39 @@ void Walls::addWall(const Edge &e, TileMap &tilemap, TileMapEntry &tme)
 		* otherwise, add it to the list
 	*/
 
-	const Segment &s = e.segment + tme.getULCorner();
-	Segment *add = NULL;
+	/* all of this is done on the grid, so there's no rounding to worry
+		about when comparing ends */
+	const GridEdge s = e.at(tme.getI(), tme.getJ());
+	GridEdge add = s;
 	const Wall *remove = NULL;
 
 	int tileI = tme.getI(), tileJ = tme.getJ();
-	WallSet set;
 
-	/* add walls to set from <i-1,j-1>,<i,j-1>,<i+1,j-1>,<i-1,j> */
-	set.addFromTile( tilemap.index(tileI-1, tileJ-1) );
-	set.addFromTile( tilemap.index(tileI+0, tileJ-1) );
-	set.addFromTile( tilemap.index(tileI+1, tileJ-1) );
-	set.addFromTile( tilemap.index(tileI-1, tileJ+0) );
+	/* add walls from <i-1,j-1>,<i,j-1>,<i+1,j-1>,<i-1,j>. a wall can be in
+		more than one of them, so they're sorted and the repeats dropped.
+		they're sorted in the order they were made: which one an edge is
+		merged with shouldn't depend on where the arena put them. the row
+		above the band's top is left to stitch */
+	CPVector &nearby = b.nearby;
+	nearby.clear();
+	if (tileJ > b.top)
+	{
+		addNearby( b, tilemap.index(tileI-1, tileJ-1) );
+		addNearby( b, tilemap.index(tileI+0, tileJ-1) );
+		addNearby( b, tilemap.index(tileI+1, tileJ-1) );
+	}
+	addNearby( b, tilemap.index(tileI-1, tileJ+0) );
+	std::sort(nearby.begin(), nearby.end(), MadeBefore());
+	nearby.erase(std::unique(nearby.begin(), nearby.end()), nearby.end());
 
-	WallSet::Iterator i;
+	CPVector::const_iterator i;
 
-	for (i = set.begin(); i != set.end(); ++i)
+	for (i = nearby.begin(); i != nearby.end(); ++i)
 	{
-		const Edge &e2 = (*i)->wall;
-		const Segment &t = e2.segment;
+		const GridEdge &t = (*i)->grid;
 
 		/* p0 and p1 are return values */
-		Point p0, p1;
+		GridPoint p0, p1;
 		Segment::IntersectType it = s.intersect(t,p0,p1);
 		switch (it)
 		{
@@ -99,11 +301,11 @@ void Walls::addWall(const Edge &e, TileMap &tilemap, TileMapEntry &tme)
 			continue;
 		case Segment::COLLINEAR_POINT:
 			/* normals must be the same to combine */
-			if (s.normal != t.normal)
+			if (!s.sameDirection(t))
 				break;
 
 			/* can only combine like types */
-			if (e.type != e2.type)
+			if (e.type != t.type)
 				break;
 
 			if (p0 == t.p0)
@@ -112,7 +314,7 @@ void Walls::addWall(const Edge &e, TileMap &tilemap, TileMapEntry &tme)
 				 extend t back to s
 				*/
 
-				add = new Segment(s.p0, t.p1);
+				add = GridEdge(s.p0, t.p1, e.type);
 			}
 			else
 			{
@@ -120,7 +322,7 @@ void Walls::addWall(const Edge &e, TileMap &tilemap, TileMapEntry &tme)
 				extend t to s
 				*/
 
-				add = new Segment(t.p0, s.p1);
+				add = GridEdge(t.p0, s.p1, e.type);
 			}
 
 			remove = *i;
@@ -129,23 +331,18 @@ void Walls::addWall(const Edge &e, TileMap &tilemap, TileMapEntry &tme)
 			/* normals must be opposite to cancel out */
 			/* (shouldn't be otherwise, anyway -- it would imply that two 
 				tiles were added to the same place) */
-			assert(s.normal == -t.normal);
+			assert(!s.sameDirection(t));
 
 			/* can only cancel like types, or a one way with a weak, or a ladder top with a ladder */
-			if (e.type != e2.type && 
-				!( (e.type == Edge::ONE_WAY && e2.type == Edge::WEAK) ||
-					(e.type == Edge::WEAK && e2.type == Edge::ONE_WAY) ||
-					(e.type == Edge::LADDER_TOP && e2.type == Edge::LADDER) ||
-					(e.type == Edge::LADDER && e2.type == Edge::LADDER_TOP) )
+			if (e.type != t.type && 
+				!( (e.type == Edge::ONE_WAY && t.type == Edge::WEAK) ||
+					(e.type == Edge::WEAK && t.type == Edge::ONE_WAY) ||
+					(e.type == Edge::LADDER_TOP && t.type == Edge::LADDER) ||
+					(e.type == Edge::LADDER && t.type == Edge::LADDER_TOP) )
 				)
 				break;
 
-			/* delete add if it has been created */
-			if (add)
-				delete add;
-
 			Wall *new1 = NULL, *new2 = NULL;
-			Segment *s1 = NULL, *s2 = NULL;
 
 			/* here we make some assumptions about the way edges are defined in
 				Tile::makeTiles and how Segment::intersect returns p0 and p1:
@@ -174,16 +371,16 @@ void Walls::addWall(const Edge &e, TileMap &tilemap, TileMapEntry &tme)
 				/* t is the short segment,
 				   remove t portion of s, keep ends (if any) */
 
-				if (s.p0 != p1) s1 = new Segment(s.p0, p1);
-				if (p0 != s.p1) s2 = new Segment(p0, s.p1);
+				if (s.p0 != p1) new1 = addWall(b, GridEdge(s.p0, p1, t.type));
+				if (p0 != s.p1) new2 = addWall(b, GridEdge(p0, s.p1, t.type));
 			}
 			else if ( p0 == s.p1 && p1 == s.p0 )
 			{
 				/* s is the short segment,
 					remove s portion of t, keep ends (if any) */
 
-				if (t.p0 != p0) s1 = new Segment(t.p0, p0);
-				if (p1 != t.p1) s2 = new Segment(p1, t.p1);
+				if (t.p0 != p0) new1 = addWall(b, GridEdge(t.p0, p0, t.type));
+				if (p1 != t.p1) new2 = addWall(b, GridEdge(p1, t.p1, t.type));
 			}
 			else
 			{
@@ -191,57 +388,44 @@ void Walls::addWall(const Edge &e, TileMap &tilemap, TileMapEntry &tme)
 				assert(0);
 			}
 
-			/* add the new walls */
-			if (s1)
-			{
-				walls.push_back(Edge(*s1, e2.type));
-				new1 = &walls.back();
-				delete s1;
-			}
-
-			if (s2)
-			{
-				walls.push_back(Edge(*s2, e2.type));
-				new2 = &walls.back();
-				delete s2;
-			}
-
 			/* remap the old wall */
 			remapWall( **i, new1, new2 );
 			/* remove the old wall */
-			removeWall(*i);
+			removeWall(b, *i);
 			return;
 			break;
 		}
 	}
 
-	if (add != NULL)
+	if (remove != NULL)
 	{
 		/* combine */
-		walls.push_back( Wall(Edge(*add, e.type)) );
-		delete(add);
-
-		Wall *new1 = &walls.back();
+		Wall *new1 = addWall(b, add);
 
 		tme.addWall( new1 );
 		new1->addTile(&tme);
 
 		remapWall(*remove, new1, NULL);
-		removeWall(remove);
+		removeWall(b, remove);
 	}
 	else
 	{
-		Wall w( Edge(s,e.type) );
+		Wall *w = addWall(b, s);
 
 		/* add the TileMapEntry to the wall */
-		w.addTile(&tme);
-		/* add the Wall to the main list */
-		walls.push_back( w );
+		w->addTile(&tme);
 		/* add the Wall to the TileMapEntry list */
-		tme.addWall( &walls.back() );
+		tme.addWall(w);
 	}
 }
 
+void Walls::addNearby(Band &b, const TileMapEntry *tme)
+{
+	/* TileMapEntries are NULL out of bounds */
+	if (tme)
+		b.nearby.insert(b.nearby.end(), tme->getWalls().begin(), tme->getWalls().end());
+}
+
 void Walls::remapWall(const Wall &w, Wall *new1, Wall *new2)
 {
 	TileMapEntry::PListConstIterator i;
@@ -256,7 +440,7 @@ void Walls::remapWall(const Wall &w, Wall *new1, Wall *new2)
 		walls.erase(std::find(walls.begin(), walls.end(), &w));
 
 		/* find to which new wall segment each tile belongs */
-		Edge::ListConstIterator j;
+		std::vector<GridEdge>::const_iterator j;
 		const Tile &t = tme.getTile();
 
 		if (new1 != NULL && new2 != NULL)
@@ -264,16 +448,16 @@ void Walls::remapWall(const Wall &w, Wall *new1, Wall *new2)
 			/* not the most efficient method, but eh... */
 			for (j = t.edges.begin(); j != t.edges.end(); ++j)
 			{
-				const Edge &e = *j;
+				const GridEdge &e = *j;
 
-				if (new1 && new1->wall.segment.contains(e.segment + tme.getULCorner()))
+				if (new1 && new1->grid.contains(e.at(tme.getI(), tme.getJ())))
 				{
 					tme.addWall(new1);
 					new1->addTile(&tme);
 					break;
 				}
 
-				if (new2 && new2->wall.segment.contains(e.segment + tme.getULCorner()))
+				if (new2 && new2->grid.contains(e.at(tme.getI(), tme.getJ())))
 				{
 					tme.addWall(new2);
 					new2->addTile(&tme);
@@ -294,31 +478,60 @@ void Walls::remapWall(const Wall &w, Wall *new1, Wall *new2)
 	}
 }
 
-void Walls::removeWall(const Wall *w)
+Wall *Walls::addWall(Band &b, const GridEdge &e)
 {
-	/* look for the wall to erase */
+	/* until buildIndex, index is the order the walls were made in */
+	b.walls.push_back(Wall(e, arena));
+	b.walls.back().index = b.made.size();
+	b.made.push_back(--b.walls.end());
+	b.keys.push_back(b.key++);
+	return &b.walls.back();
+}
+
+void Walls::removeWall(Band &b, const Wall *w)
+{
+	/* searching the list for it was most of the time spent building */
+	b.walls.erase(b.made[w->index]);
+}
+
+void Walls::buildIndex()
+{
+	/* walls are merged and removed while the tiles are added, so they can
+		only be numbered once everything is done */
+	index.clear();
+	index.reserve(walls.size());
+	batch.clear();
+	batch.reserve(walls.size());
+
 	Wall::ListIterator i;
 	for (i = walls.begin(); i != walls.end(); ++i)
-		if (w == &*i)
-		{
-			walls.erase(i);
-			break;
-		}
+	{
+		/* the walls are final, so this is where they get their Segments */
+		(*i).wall.segment = (*i).grid.toSegment();
+		(*i).index = index.size();
+		index.push_back(&*i);
+		batch.add((*i).wall.segment);
+	}
+
+	tree.build(index);
 }
 
-void Walls::addTile(TileMap &tilemap, TileMapEntry &tme)
+void Walls::addTile(Band &b, TileMap &tilemap, TileMapEntry &tme)
 {
-	Edge::ListConstIterator i;
 	const Tile &t = tme.getTile();
+	assert((int)t.edges.size() <= MAX_EDGES);
 
-	for (i = t.edges.begin(); i != t.edges.end(); ++i)
-		addWall(*i, tilemap, tme);
+	for (unsigned int i = 0; i < t.edges.size(); i++)
+	{
+		b.key = makeKey(tme, i);
+		addWall(b, t.edges[i], tilemap, tme);
+	}
 }
 
-void Walls::draw()
+void Walls::draw(SpriteBatch &batch)
 {
+	static const Color Black(0,0,0,255), Red(255,0,0,255);
 	Wall::ListConstIterator i;
-	glBegin(GL_LINES);
 
 	for (i = walls.begin(); i != walls.end(); ++i)
 	{
@@ -326,21 +539,12 @@ void Walls::draw()
 		const Segment &s = w.wall.segment;
 		const Point &p0 = s.p0, &p1 = s.p1;
 
-		glColor3f(0.0f, 0.0f, 0.0f);
-
 		/* draw wall */
-		glVertex2f(p0.x, p0.y);
-		glVertex2f(p1.x, p1.y);
+		batch.line(p0, p1, Black);
 
 		/* draw normal, 4 pixels long, starting from the midpoint of the 
 			segment */
 		Point pm( (p0.x + p1.x)/2, (p0.y + p1.y)/2 );
-
-		glColor3f(1.0f, 0.0f, 0.0f);
-
-		glVertex2f(pm.x, pm.y);
-		glVertex2f(pm.x + 4 * s.normal.u, pm.y + 4 * s.normal.v);
+		batch.line(pm, Point(pm.x + 4 * s.normal.u, pm.y + 4 * s.normal.v), Red);
 	}
-
-	glEnd();
 }
@@ -0,0 +1,377 @@
+/***************************************************************************
+* SimFun
+*  walltree.cpp -- bounding box tree for long range wall queries
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+
+#include <algorithm>
+#include <math.h>
+#include "walltree.h"
+
+const int WallTree::LEAF_SIZE = 4;
+
+WallTree::Box::Box(const Segment &s):
+	l(std::min(s.p0.x, s.p1.x)), t(std::min(s.p0.y, s.p1.y)),
+	r(std::max(s.p0.x, s.p1.x)), b(std::max(s.p0.y, s.p1.y))
+{
+}
+
+WallTree::Box::Box(const Circle &c):
+	l(c.center.x - c.radius), t(c.center.y - c.radius),
+	r(c.center.x + c.radius), b(c.center.y + c.radius)
+{
+}
+
+void WallTree::Box::add(const Box &o)
+{
+	l = std::min(l, o.l);
+	t = std::min(t, o.t);
+	r = std::max(r, o.r);
+	b = std::max(b, o.b);
+}
+
+/* the part of p + t*d (0 <= t <= tmax) inside the box, for one axis */
+static bool clipAxis(real p, real d, real lo, real hi, real &t0, real &t1)
+{
+	if (d == 0) return lo <= p && p <= hi;
+
+	real a = (lo - p) / d, b = (hi - p) / d;
+	if (a > b) std::swap(a, b);
+	t0 = std::max(t0, a);
+	t1 = std::min(t1, b);
+	return t0 <= t1;
+}
+
+static bool clip(const WallTree::Box &box, const Point &p, const Vector &d, real tmax)
+{
+	real t0 = 0, t1 = tmax;
+	return clipAxis(p.x, d.u, box.l, box.r, t0, t1) &&
+		clipAxis(p.y, d.v, box.t, box.b, t0, t1);
+}
+
+/* where p + t*d crosses q0-q1. moving along the segment (parallel) doesn't
+	count as crossing it */
+static bool raySegment(const Point &p, const Vector &d, const Point &q0,
+	const Point &q1, real &t)
+{
+	Vector e(q0, q1), w(p, q0);
+	real denom = Vector::perp(d, e);
+	if (denom == 0) return false;
+
+	real tt = Vector::perp(w, e) / denom;
+	real u = Vector::perp(w, d) / denom;
+	if (tt < 0 || u < 0 || u > 1) return false;
+
+	t = tt;
+	return true;
+}
+
+static bool rayCircle(const Point &p, const Vector &d, const Point &center,
+	real radius, real &t)
+{
+	Vector f(center, p);
+	real a = Vector::dot(d, d), b = Vector::dot(f, d);
+	real c = Vector::dot(f, f) - radius * radius;
+
+	real disc = b * b - a * c;
+	if (a == 0 || disc < 0) return false;
+
+	real tt = (-b - (real)sqrt(disc)) / a;
+	if (tt < 0) return false;
+
+	t = tt;
+	return true;
+}
+
+/* a moving circle touches the segment when its center touches the
+	segment's capsule: two sides (the segment pushed out along the normal)
+	and a round cap on each end */
+static bool sweepSegment(const Circle &c, const Vector &d, const Segment &s, real &t)
+{
+	if (s.intersect(c))
+	{
+		t = 0;
+		return true;
+	}
+
+	Vector n = s.normal * c.radius;
+	real tt;
+	bool hit = false;
+
+	t = REAL_MAX;
+	if (raySegment(c.center, d, s.p0 + n, s.p1 + n, tt)) { t = std::min(t, tt); hit = true; }
+	if (raySegment(c.center, d, s.p0 - n, s.p1 - n, tt)) { t = std::min(t, tt); hit = true; }
+	if (rayCircle(c.center, d, s.p0, c.radius, tt)) { t = std::min(t, tt); hit = true; }
+	if (rayCircle(c.center, d, s.p1, c.radius, tt)) { t = std::min(t, tt); hit = true; }
+
+	return hit;
+}
+
+void WallTree::build(const std::vector<const Wall *, Allocator<const Wall *> > &index)
+{
+	nodes.clear();
+	walls.clear();
+	if (index.empty()) return;
+
+	std::vector<Entry> entries(index.size());
+	for (unsigned int i = 0; i < index.size(); i++)
+	{
+		Entry &e = entries[i];
+		const Segment &s = index[i]->wall.segment;
+
+		e.wall = index[i];
+		e.box = Box(s);
+		e.cx = (s.p0.x + s.p1.x) / 2;
+		e.cy = (s.p0.y + s.p1.y) / 2;
+	}
+
+	/* leaves have at least LEAF_SIZE/2 walls, so there are fewer nodes
+		than walls */
+	nodes.reserve(index.size());
+	walls.reserve(index.size());
+	build(entries, 0, entries.size());
+}
+
+int WallTree::build(std::vector<Entry> &entries, int begin, int end)
+{
+	int n = nodes.size();
+	nodes.push_back(Node());
+
+	Box box = entries[begin].box;
+	real cl = entries[begin].cx, cr = cl, ct = entries[begin].cy, cb = ct;
+	for (int i = begin + 1; i < end; i++)
+	{
+		const Entry &e = entries[i];
+		box.add(e.box);
+		cl = std::min(cl, e.cx); cr = std::max(cr, e.cx);
+		ct = std::min(ct, e.cy); cb = std::max(cb, e.cy);
+	}
+	nodes[n].box = box;
+
+	if (end - begin <= LEAF_SIZE)
+	{
+		nodes[n].first = walls.size();
+		nodes[n].count = end - begin;
+		for (int i = begin; i < end; i++)
+			walls.push_back(entries[i].wall);
+		return n;
+	}
+
+	/* split at the median, across the longer side of the centers */
+	int mid = (begin + end) / 2;
+	if (cr - cl > cb - ct)
+		std::nth_element(entries.begin() + begin, entries.begin() + mid,
+			entries.begin() + end, CompareX());
+	else
+		std::nth_element(entries.begin() + begin, entries.begin() + mid,
+			entries.begin() + end, CompareY());
+
+	build(entries, begin, mid);
+	int second = build(entries, mid, end);
+
+	nodes[n].first = second;
+	nodes[n].count = 0;
+	return n;
+}
+
+bool WallTree::raycast(const Point &p, const Vector &d, Hit &hit, int types) const
+{
+	if (nodes.empty()) return false;
+
+	int stack[MAX_DEPTH], top = 0;
+	real best = 1;
+	hit.wall = NULL;
+
+	stack[top++] = 0;
+	while (top)
+	{
+		int n = stack[--top];
+		const Node &node = nodes[n];
+		if (!clip(node.box, p, d, best)) continue;
+
+		if (node.count == 0)
+		{
+			stack[top++] = node.first;
+			stack[top++] = n + 1;
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			const Wall &w = *walls[i];
+			const Segment &s = w.wall.segment;
+			real t;
+
+			if (accepts(w, types) && raySegment(p, d, s.p0, s.p1, t) && t <= best)
+			{
+				best = t;
+				hit.wall = &w;
+			}
+		}
+	}
+
+	if (hit.wall == NULL) return false;
+
+	hit.t = best;
+	hit.point = p + d * best;
+	return true;
+}
+
+bool WallTree::lineOfSight(const Point &a, const Point &b, int types) const
+{
+	if (nodes.empty()) return true;
+
+	Vector d(a, b);
+	int stack[MAX_DEPTH], top = 0;
+
+	stack[top++] = 0;
+	while (top)
+	{
+		int n = stack[--top];
+		const Node &node = nodes[n];
+		if (!clip(node.box, a, d, 1)) continue;
+
+		if (node.count == 0)
+		{
+			stack[top++] = node.first;
+			stack[top++] = n + 1;
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			const Wall &w = *walls[i];
+			const Segment &s = w.wall.segment;
+			real t;
+
+			if (accepts(w, types) && raySegment(a, d, s.p0, s.p1, t) && t <= 1)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool WallTree::sweep(const Circle &c, const Vector &d, Hit &hit, int types) const
+{
+	if (nodes.empty()) return false;
+
+	int stack[MAX_DEPTH], top = 0;
+	real best = 1;
+	hit.wall = NULL;
+
+	stack[top++] = 0;
+	while (top)
+	{
+		/* a box grown by the radius is hit when the circle's box is */
+		int n = stack[--top];
+		const Node &node = nodes[n];
+		Box box(node.box.l - c.radius, node.box.t - c.radius,
+			node.box.r + c.radius, node.box.b + c.radius);
+		if (!clip(box, c.center, d, best)) continue;
+
+		if (node.count == 0)
+		{
+			stack[top++] = node.first;
+			stack[top++] = n + 1;
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			const Wall &w = *walls[i];
+			real t;
+
+			if (accepts(w, types) && sweepSegment(c, d, w.wall.segment, t) && t <= best)
+			{
+				best = t;
+				hit.wall = &w;
+			}
+		}
+	}
+
+	if (hit.wall == NULL) return false;
+
+	hit.t = best;
+	hit.point = c.center + d * best;
+	return true;
+}
+
+void WallTree::query(const Circle &c, WallSet &set, int types) const
+{
+	if (nodes.empty()) return;
+
+	Box box(c);
+	int stack[MAX_DEPTH], top = 0;
+
+	stack[top++] = 0;
+	while (top)
+	{
+		int n = stack[--top];
+		const Node &node = nodes[n];
+		if (!node.box.overlaps(box)) continue;
+
+		if (node.count == 0)
+		{
+			stack[top++] = node.first;
+			stack[top++] = n + 1;
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			const Wall &w = *walls[i];
+			if (accepts(w, types) && w.wall.segment.intersect(c))
+				set.add(w);
+		}
+	}
+}
+
+void WallTree::query(const Box &box, WallSet &set, int types) const
+{
+	if (nodes.empty()) return;
+
+	int stack[MAX_DEPTH], top = 0;
+
+	stack[top++] = 0;
+	while (top)
+	{
+		int n = stack[--top];
+		const Node &node = nodes[n];
+		if (!node.box.overlaps(box)) continue;
+
+		if (node.count == 0)
+		{
+			stack[top++] = node.first;
+			stack[top++] = n + 1;
+			continue;
+		}
+
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			const Wall &w = *walls[i];
+			const Segment &s = w.wall.segment;
+			if (accepts(w, types) && clip(box, s.p0, Vector(s.p0, s.p1), 1))
+				set.add(w);
+		}
+	}
+}
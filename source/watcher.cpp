@@ -0,0 +1,157 @@
+/***************************************************************************
+* SimFun
+*  watcher.cpp -- watches asset files for changes
+* Copyright (C) 2004	Ben Smith
+*
+* This program is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program; if not, write to the Free Software
+* Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+* The license can be found at http://www.gnu.org/copyleft/.
+* The author can be contacted at bats@hush.com
+*
+*****************************************************************************/
+
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "SDL.h"
+#include "watcher.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#define USE_INOTIFY
+#endif
+
+const Uint32 AssetWatcher::POLL_INTERVAL = 500;
+
+AssetWatcher::AssetWatcher():
+	notify(-1), lastPoll(0)
+{
+#ifdef USE_INOTIFY
+	notify = inotify_init();
+	if (notify >= 0)
+		fcntl(notify, F_SETFL, fcntl(notify, F_GETFL) | O_NONBLOCK);
+#endif
+}
+
+AssetWatcher::~AssetWatcher()
+{
+#ifdef USE_INOTIFY
+	if (notify >= 0) close(notify);
+#endif
+}
+
+time_t AssetWatcher::modifiedTime(const char *file)
+{
+	struct stat st;
+	if (stat(file, &st) != 0) return 0;
+	return st.st_mtime;
+}
+
+void AssetWatcher::watch(const char *file, int id)
+{
+	Asset a;
+	a.file = file;
+	a.id = id;
+	a.watch = -1;
+	a.mtime = modifiedTime(file);
+
+	/* split off the directory. windows paths can use either kind of
+		slash; elsewhere a backslash is part of a name */
+#if defined(_WIN32)
+	std::string::size_type slash = a.file.find_last_of("/\\");
+#else
+	std::string::size_type slash = a.file.find_last_of('/');
+#endif
+	std::string dir = (slash == std::string::npos) ? "." : a.file.substr(0, slash);
+	a.name = (slash == std::string::npos) ? a.file : a.file.substr(slash + 1);
+
+#ifdef USE_INOTIFY
+	/* watch the directory, not the file -- most editors save by writing a
+		new file and renaming it over the old one, which would lose a watch
+		on the file itself. adding the same directory twice returns the same
+		watch. creating the file isn't watched: it's still empty then, and
+		the write that follows ends in IN_CLOSE_WRITE anyway */
+	if (notify >= 0)
+	{
+		int w = inotify_add_watch(notify, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+		/* a directory that can't be watched (missing, or out of watches)
+			is left to checkTimes, which polls everything without a watch */
+		a.watch = w >= 0 ? w : -1;
+	}
+#endif
+
+	assets.push_back(a);
+}
+
+void AssetWatcher::readEvents(std::vector<int> &changed)
+{
+#ifdef USE_INOTIFY
+	char buffer[4096];
+	ssize_t len;
+
+	while ((len = read(notify, buffer, sizeof(buffer))) > 0)
+	{
+		for (char *p = buffer; p < buffer + len; )
+		{
+			const struct inotify_event *e = (const struct inotify_event *)p;
+
+			std::vector<Asset>::const_iterator i;
+			for (i = assets.begin(); i != assets.end(); ++i)
+				if (e->len && (*i).watch == e->wd && (*i).name == e->name)
+					changed.push_back((*i).id);
+
+			p += sizeof(struct inotify_event) + e->len;
+		}
+	}
+#endif
+}
+
+void AssetWatcher::checkTimes(std::vector<int> &changed)
+{
+	Uint32 now = SDL_GetTicks();
+	if (now - lastPoll < POLL_INTERVAL) return;
+	lastPoll = now;
+
+	std::vector<Asset>::iterator i;
+	for (i = assets.begin(); i != assets.end(); ++i)
+	{
+		Asset &a = *i;
+		if (a.watch >= 0) continue;
+
+		time_t t = modifiedTime(a.file.c_str());
+
+		if (t != 0 && t != a.mtime)
+		{
+			a.mtime = t;
+			changed.push_back(a.id);
+		}
+	}
+}
+
+void AssetWatcher::poll(std::vector<int> &changed)
+{
+	std::vector<int>::size_type first = changed.size();
+
+	/* files that couldn't be given an inotify watch are polled */
+	if (notify >= 0) readEvents(changed);
+	checkTimes(changed);
+
+	/* saving a file usually generates several events; report it once */
+	std::sort(changed.begin() + first, changed.end());
+	changed.erase(std::unique(changed.begin() + first, changed.end()), changed.end());
+}
\ No newline at end of file